@@ -0,0 +1,95 @@
+/*****************************************************************//**
+ * \file   benchmark.h
+ * \brief  Contains settings and results shared by the benchmark harness
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "Engine/types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief What to do with golden images (see golden.h).
+ */
+enum class GoldenMode
+{
+	None, Verify, Record
+};
+
+/**
+ * \brief Describes a single benchmark run. Filled from the command line.
+ */
+struct BenchmarkSettings
+{
+	/* Offscreen Buffer */
+	int width = 1280;
+	int height = 720;
+
+	/* World Properties (see GameSettings) */
+	int world_num_objects_x = 16;
+	int world_num_objects_y = 16;
+	int world_num_objects_z = 16;
+	uint32_t seed = 1;
+
+	/* Flythrough */
+	int frames = 600;				///< Number of measured frames
+	int warmupFrames = 30;			///< Frames rendered before measuring
+	bool countOverdraw = false;		///< Count pixels covered more than once a frame
+	bool depthPrepass = false;		///< Draw depth before colour (RasterOptions::depthPrepass)
+	bool tiledTargets = false;		///< Draw to tiled buffers (RasterOptions::tiledTargets)
+	bool fastClear = false;			///< Clear tiles when first drawn (RasterOptions::fastClear)
+	int perspectiveSpan = 0;		///< Pixels between perspective divides (RasterOptions::perspectiveSpan)
+
+	/* Micro-benchmarks (see microbench.h) */
+	bool micro = false;				///< Run kernel micro-benchmarks instead of the flythrough
+	std::string filter;				///< Only run kernels whose name contains this
+	float minTimeMs = 200.0f;		///< Minimum time to run each kernel for
+
+	/* Golden images (see golden.h) */
+	GoldenMode golden = GoldenMode::None;
+	std::string goldenDir = "golden/";	///< Directory of reference images and budgets.txt
+	float budgetThreshold = 0.25f;		///< Allowed slowdown over budget (negative disables)
+
+	/* Files */
+	std::string assetPath = "../../Game/Game/";	///< Directory containing cubemap_*.bmp
+	std::string csvFile;						///< Summary row appended here (optional)
+	std::string jsonFile;						///< Summary and frame times written here (optional)
+	std::string label = "baseline";				///< Name of run in reports
+};
+
+/**
+ * \brief Results of a benchmark run.
+ */
+struct BenchmarkResult
+{
+	std::vector<float> vFrameMs;		///< Time of every measured frame
+
+	float fMeanMs = 0.0f;
+	float fP50Ms = 0.0f;
+	float fP95Ms = 0.0f;
+	float fP99Ms = 0.0f;
+	float fMinMs = 0.0f;
+	float fMaxMs = 0.0f;
+
+	uint64_t trianglesSubmitted = 0;
+	uint64_t trianglesRasterised = 0;
+	uint64_t pixelsTested = 0;
+	uint64_t pixelsWritten = 0;
+	uint64_t pixelsOverdrawn = 0;		///< Only counted with countOverdraw
+	uint64_t trianglesHidden = 0;		///< Skipped by tile depth bounds
+	uint64_t verticesTransformed = 0;	///< Mesh vertices moved to world space
+	double trianglesPerSecond = 0.0;	///< Rasterised triangles per second
+	double pixelsPerSecond = 0.0;		///< Written pixels per second
+
+	uint64_t peakMemoryBytes = 0;		///< Peak resident memory of process
+};
+
+extern void computeStats(BenchmarkResult& result);
+extern uint64_t getPeakMemoryBytes();
+extern void printResult(const BenchmarkSettings& settings, const BenchmarkResult& result);
+extern const bool appendCSV(const BenchmarkSettings& settings, const BenchmarkResult& result);
+extern const bool writeJSON(const BenchmarkSettings& settings, const BenchmarkResult& result);
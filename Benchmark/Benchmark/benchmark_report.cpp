@@ -0,0 +1,223 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+#ifdef _WIN32
+	#include "Engine/hwindows.h"
+	#include <psapi.h>
+	#pragma comment(lib, "psapi.lib")
+#else
+	#include <sys/resource.h>
+#endif
+
+/**
+ * \brief Returns the nearest-rank percentile of sorted values.
+ */
+static float percentile(const std::vector<float>& sorted, const float p)
+{
+	if (sorted.empty())
+	{
+		return 0.0f;
+	}
+
+	size_t rank = (size_t)((p / 100.0f) * (float)sorted.size() + 0.5f);
+	rank = std::min(std::max(rank, (size_t)1), sorted.size());
+	return sorted[rank - 1];
+}
+
+/**
+ * \brief Fills the frame time statistics of result from vFrameMs.
+ */
+void computeStats(BenchmarkResult& result)
+{
+	if (result.vFrameMs.empty())
+	{
+		return;
+	}
+
+	std::vector<float> sorted = result.vFrameMs;
+	std::sort(sorted.begin(), sorted.end());
+
+	const double totalMs = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+	result.fMeanMs = (float)(totalMs / (double)sorted.size());
+	result.fP50Ms = percentile(sorted, 50.0f);
+	result.fP95Ms = percentile(sorted, 95.0f);
+	result.fP99Ms = percentile(sorted, 99.0f);
+	result.fMinMs = sorted.front();
+	result.fMaxMs = sorted.back();
+
+	const double totalSeconds = totalMs / 1000.0;
+	if (totalSeconds > 0.0)
+	{
+		result.trianglesPerSecond = (double)result.trianglesRasterised / totalSeconds;
+		result.pixelsPerSecond = (double)result.pixelsWritten / totalSeconds;
+	}
+}
+
+/**
+ * \brief Returns the peak resident memory of this process in bytes.
+ */
+uint64_t getPeakMemoryBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return (uint64_t)counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		return (uint64_t)usage.ru_maxrss * 1024;  // kilobytes
+	}
+	return 0;
+#endif
+}
+
+/**
+ * \brief Prints a human readable summary to stdout.
+ */
+void printResult(const BenchmarkSettings& settings, const BenchmarkResult& result)
+{
+	std::cout << std::fixed << std::setprecision(3)
+		<< "[" << settings.label << "] "
+		<< settings.width << "x" << settings.height << " world "
+		<< settings.world_num_objects_x << "x" << settings.world_num_objects_y << "x" << settings.world_num_objects_z
+		<< " seed " << settings.seed << " frames " << result.vFrameMs.size()
+		<< (settings.depthPrepass ? " prepass" : "")
+		<< (settings.tiledTargets ? " tiled" : "")
+		<< (settings.fastClear ? " fast-clear" : "")
+		<< (settings.perspectiveSpan > 1 ? " perspective-span " + std::to_string(settings.perspectiveSpan) : "") << "\n"
+		<< "  frame ms   mean " << result.fMeanMs
+		<< "  p50 " << result.fP50Ms
+		<< "  p95 " << result.fP95Ms
+		<< "  p99 " << result.fP99Ms
+		<< "  min " << result.fMinMs
+		<< "  max " << result.fMaxMs << "\n"
+		<< std::setprecision(0)
+		<< "  triangles/s " << result.trianglesPerSecond
+		<< "  pixels/s " << result.pixelsPerSecond << "\n"
+		<< "  hidden triangles " << result.trianglesHidden << " of " << result.trianglesRasterised << "\n"
+		<< "  vertices transformed " << result.verticesTransformed << " for " << result.trianglesSubmitted << " triangles\n"
+		<< "  peak memory " << (result.peakMemoryBytes / (1024 * 1024)) << " MiB\n";
+
+	if (settings.countOverdraw && !result.vFrameMs.empty())
+	{
+		std::cout << "  overdrawn pixels/frame " << result.pixelsOverdrawn / result.vFrameMs.size()
+			<< " of " << result.pixelsTested / result.vFrameMs.size() << " covered\n";
+	}
+}
+
+/**
+ * \brief Appends a summary row to settings.csvFile, writing the header 
+ * first if the file is new, so that runs accumulate against a baseline.
+ * 
+ * \return Returns true if successful (or no file requested), otherwise false
+ */
+const bool appendCSV(const BenchmarkSettings& settings, const BenchmarkResult& result)
+{
+	if (settings.csvFile.empty())
+	{
+		return true;
+	}
+
+	bool writeHeader;
+	{
+		std::ifstream existing(settings.csvFile);
+		writeHeader = !existing.good() || existing.peek() == std::ifstream::traits_type::eof();
+	}
+
+	std::ofstream file(settings.csvFile, std::ios::app);
+	if (!file.is_open())
+	{
+		std::cerr << "Error writing: " << settings.csvFile << " -> Could not open file\n";
+		return false;
+	}
+
+	if (writeHeader)
+	{
+		file << "label,width,height,world_x,world_y,world_z,seed,frames,"
+			"mean_ms,p50_ms,p95_ms,p99_ms,min_ms,max_ms,"
+			"triangles_submitted,triangles_rasterised,pixels_tested,pixels_written,"
+			"triangles_per_second,pixels_per_second,peak_memory_bytes\n";
+	}
+
+	file << std::fixed << std::setprecision(4)
+		<< settings.label << ","
+		<< settings.width << "," << settings.height << ","
+		<< settings.world_num_objects_x << "," << settings.world_num_objects_y << "," << settings.world_num_objects_z << ","
+		<< settings.seed << "," << result.vFrameMs.size() << ","
+		<< result.fMeanMs << "," << result.fP50Ms << "," << result.fP95Ms << "," << result.fP99Ms << ","
+		<< result.fMinMs << "," << result.fMaxMs << ","
+		<< result.trianglesSubmitted << "," << result.trianglesRasterised << ","
+		<< result.pixelsTested << "," << result.pixelsWritten << ","
+		<< std::setprecision(0) << result.trianglesPerSecond << "," << result.pixelsPerSecond << ","
+		<< result.peakMemoryBytes << "\n";
+
+	return true;
+}
+
+/**
+ * \brief Writes settings, summary and every frame time to settings.jsonFile.
+ * 
+ * \return Returns true if successful (or no file requested), otherwise false
+ */
+const bool writeJSON(const BenchmarkSettings& settings, const BenchmarkResult& result)
+{
+	if (settings.jsonFile.empty())
+	{
+		return true;
+	}
+
+	std::ofstream file(settings.jsonFile);
+	if (!file.is_open())
+	{
+		std::cerr << "Error writing: " << settings.jsonFile << " -> Could not open file\n";
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(4)
+		<< "{\n"
+		<< "  \"label\": \"" << settings.label << "\",\n"
+		<< "  \"width\": " << settings.width << ",\n"
+		<< "  \"height\": " << settings.height << ",\n"
+		<< "  \"world\": [" << settings.world_num_objects_x << ", " << settings.world_num_objects_y << ", " << settings.world_num_objects_z << "],\n"
+		<< "  \"seed\": " << settings.seed << ",\n"
+		<< "  \"depth_prepass\": " << (settings.depthPrepass ? "true" : "false") << ",\n"
+		<< "  \"tiled_targets\": " << (settings.tiledTargets ? "true" : "false") << ",\n"
+		<< "  \"fast_clear\": " << (settings.fastClear ? "true" : "false") << ",\n"
+		<< "  \"perspective_span\": " << settings.perspectiveSpan << ",\n"
+		<< "  \"frames\": " << result.vFrameMs.size() << ",\n"
+		<< "  \"mean_ms\": " << result.fMeanMs << ",\n"
+		<< "  \"p50_ms\": " << result.fP50Ms << ",\n"
+		<< "  \"p95_ms\": " << result.fP95Ms << ",\n"
+		<< "  \"p99_ms\": " << result.fP99Ms << ",\n"
+		<< "  \"min_ms\": " << result.fMinMs << ",\n"
+		<< "  \"max_ms\": " << result.fMaxMs << ",\n"
+		<< "  \"triangles_submitted\": " << result.trianglesSubmitted << ",\n"
+		<< "  \"triangles_rasterised\": " << result.trianglesRasterised << ",\n"
+		<< "  \"pixels_tested\": " << result.pixelsTested << ",\n"
+		<< "  \"pixels_written\": " << result.pixelsWritten << ",\n"
+		<< "  \"pixels_overdrawn\": " << result.pixelsOverdrawn << ",\n"
+		<< "  \"triangles_hidden\": " << result.trianglesHidden << ",\n"
+		<< "  \"vertices_transformed\": " << result.verticesTransformed << ",\n"
+		<< std::setprecision(0)
+		<< "  \"triangles_per_second\": " << result.trianglesPerSecond << ",\n"
+		<< "  \"pixels_per_second\": " << result.pixelsPerSecond << ",\n"
+		<< "  \"peak_memory_bytes\": " << result.peakMemoryBytes << ",\n"
+		<< std::setprecision(4)
+		<< "  \"frame_ms\": [";
+
+	for (size_t i = 0; i < result.vFrameMs.size(); i++)
+	{
+		file << (i == 0 ? "" : ", ") << result.vFrameMs[i];
+	}
+	file << "]\n}\n";
+
+	return true;
+}
@@ -0,0 +1,172 @@
+#include "benchmark_world.h"
+#include <iostream>
+#include <random>
+#include <string>
+
+/**
+ * \brief Number of blocks between random height samples of the terrain.
+ */
+#define TERRAIN_CELL_SIZE (4)
+
+/**
+ * \brief Number of dirt blocks placed above the stone layer.
+ */
+#define TERRAIN_DIRT_DEPTH (3)
+
+BenchmarkWorld::~BenchmarkWorld()
+{
+	for (auto o : worldCoords)
+	{
+		delete o;
+	}
+	worldCoords.clear();
+	objectsToRender.clear();
+
+	delete pTextureGrass;
+	pTextureGrass = nullptr;
+	delete pTextureDirt;
+	pTextureDirt = nullptr;
+	delete pTextureStone;
+	pTextureStone = nullptr;
+	delete pMeshCube;
+	pMeshCube = nullptr;
+}
+
+Object* BenchmarkWorld::getWorldObject(const int x, const int y, const int z) const
+{
+	if ((x >= 0 && x < sizeX) && (y >= 0 && y < sizeY) && (z >= 0 && z < sizeZ))
+	{
+		return worldCoords[x + sizeX * (y + sizeY * z)];
+	}
+	else
+	{
+		return nullptr;
+	}
+}
+
+/**
+ * \brief Loads textures and fills the world with blocks.
+ * 
+ * Terrain height is bilinearly interpolated between random samples taken 
+ * every TERRAIN_CELL_SIZE blocks. Only the raw output of std::mt19937 is 
+ * used so that the same seed builds the same world with any standard 
+ * library.
+ * 
+ * \param settings Size, seed and asset path of the world
+ * \return Returns true if successful, otherwise false
+ */
+const bool BenchmarkWorld::build(const BenchmarkSettings& settings)
+{
+	sizeX = settings.world_num_objects_x;
+	sizeY = settings.world_num_objects_y;
+	sizeZ = settings.world_num_objects_z;
+
+	// Load textures
+	pTextureDirt = new Texture(TextureType::RGB, (settings.assetPath + "cubemap_dirt.bmp").c_str(), 16, 16);
+	pTextureGrass = new Texture(TextureType::RGB, (settings.assetPath + "cubemap_grass.bmp").c_str(), 16, 16);
+	pTextureStone = new Texture(TextureType::RGB, (settings.assetPath + "cubemap_stone.bmp").c_str(), 16, 16);
+	if (pTextureDirt->data == nullptr || pTextureGrass->data == nullptr || pTextureStone->data == nullptr)
+	{
+		std::cerr << "Error building world -> Could not load textures from "
+			<< settings.assetPath << "\n";
+		return false;
+	}
+
+	// Every block shares one cube
+	pMeshCube = new Mesh();
+	pMeshCube->LoadTestCube("Cube");
+
+	// Random height samples
+	std::mt19937 rng(settings.seed);
+	const int samplesX = sizeX / TERRAIN_CELL_SIZE + 2;
+	const int samplesZ = sizeZ / TERRAIN_CELL_SIZE + 2;
+	std::vector<float> samples(samplesX * samplesZ);
+	for (auto& h : samples)
+	{
+		h = (float)(rng() % 1000) / 1000.0f;
+	}
+
+	worldCoords.assign(sizeX * sizeY * sizeZ, nullptr);
+
+	for (int z = 0; z < sizeZ; z++)
+	{
+		for (int x = 0; x < sizeX; x++)
+		{
+			const int cx = x / TERRAIN_CELL_SIZE;
+			const int cz = z / TERRAIN_CELL_SIZE;
+			const float fx = (float)(x % TERRAIN_CELL_SIZE) / (float)TERRAIN_CELL_SIZE;
+			const float fz = (float)(z % TERRAIN_CELL_SIZE) / (float)TERRAIN_CELL_SIZE;
+			const float h00 = samples[cx + samplesX * cz];
+			const float h10 = samples[(cx + 1) + samplesX * cz];
+			const float h01 = samples[cx + samplesX * (cz + 1)];
+			const float h11 = samples[(cx + 1) + samplesX * (cz + 1)];
+			const float h = (h00 * (1.0f - fx) + h10 * fx) * (1.0f - fz)
+				+ (h01 * (1.0f - fx) + h11 * fx) * fz;
+
+			// Height between a quarter and three quarters of the world
+			const int height = sizeY / 4 + (int)(h * (float)(sizeY / 2));
+
+			for (int y = 0; y < height; y++)
+			{
+				Object* o = new Object();
+				std::string name;
+				if (y < height - TERRAIN_DIRT_DEPTH)
+				{
+					name = "Stone";
+					o->pTexture = pTextureStone;
+				}
+				else
+				{
+					name = "Dirt";
+					o->pTexture = pTextureDirt;
+				}
+				o->name = name;
+				o->pMesh = pMeshCube;
+				o->setPos((float)x, (float)y, (float)z);
+				o->updatePosition(0.0f);
+				worldCoords[x + sizeX * (y + sizeY * z)] = o;
+			}
+		}
+	}
+
+	// Resolve visible faces once (see Game::glRender)
+	for (int z = 0; z < sizeZ; z++)
+	{
+		for (int y = 0; y < sizeY; y++)
+		{
+			for (int x = 0; x < sizeX; x++)
+			{
+				Object* o = getWorldObject(x, y, z);
+				if (o == nullptr) continue;
+
+				Object* oRight		= getWorldObject(x - 1, y	 , z);
+				Object* oLeft		= getWorldObject(x + 1, y	 , z);
+				Object* oBottom		= getWorldObject(x	 , y - 1 , z);
+				Object* oTop		= getWorldObject(x	 , y + 1 , z);
+				Object* oFront		= getWorldObject(x	 , y	 , z - 1);
+				Object* oBehind		= getWorldObject(x	 , y	 , z + 1);
+
+				o->resetFacesDrawable();
+				if (oFront == nullptr)	o->setFaceDrawable(ObjectFace::Front);
+				if (oBehind == nullptr) o->setFaceDrawable(ObjectFace::Back);
+				if (oLeft == nullptr)	o->setFaceDrawable(ObjectFace::Left);
+				if (oRight == nullptr)	o->setFaceDrawable(ObjectFace::Right);
+				if (oTop == nullptr)	o->setFaceDrawable(ObjectFace::Top);
+				if (oBottom == nullptr) o->setFaceDrawable(ObjectFace::Bottom);
+
+				if (oTop == nullptr && o->pTexture == pTextureDirt)
+				{
+					// Convert dirt into grass if nothing ontop
+					o->replaceTexture(pTextureGrass);
+				}
+
+				if (o->faceMask != 0)
+				{
+					objectsToRender.push_back(o);
+				}
+			}
+		}
+	}
+
+	return true;
+}
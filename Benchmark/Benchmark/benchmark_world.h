@@ -0,0 +1,45 @@
+/*****************************************************************//**
+ * \file   benchmark_world.h
+ * \brief  Builds a deterministic block world like Game::glInit
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "Engine/graphics_objects.h"
+#include "Engine/graphics_texture.h"
+#include "benchmark.h"
+#include <vector>
+
+/**
+ * \brief Voxel terrain generated from a seed, with the same block, texture 
+ * and face visibility rules as the game.
+ * 
+ * The world is static, so visible faces are resolved once when it is built
+ * rather than every frame as in Game::glRender.
+ */
+class BenchmarkWorld
+{
+private:
+	int sizeX = 0;
+	int sizeY = 0;
+	int sizeZ = 0;
+	std::vector<Object*> worldCoords;	///< Every block, nullptr for air
+
+	Object* getWorldObject(const int x, const int y, const int z) const;
+
+public:
+	Texture* pTextureGrass = nullptr;
+	Texture* pTextureDirt = nullptr;
+	Texture* pTextureStone = nullptr;
+	Mesh* pMeshCube = nullptr;				///< Shared by every block
+
+	std::vector<MeshInstance*> objectsToRender;	///< Blocks with at least one visible face
+
+	~BenchmarkWorld();
+	const bool build(const BenchmarkSettings& settings);
+	int getSizeX() const { return sizeX; }
+	int getSizeY() const { return sizeY; }
+	int getSizeZ() const { return sizeZ; }
+};
@@ -0,0 +1,600 @@
+#include "golden.h"
+#include "benchmark_world.h"
+#include "Engine/graphics_offscreen.h"
+#include "Engine/utils.h"
+#include "Engine/utils_vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#define BMP_HEADER_SIZE (54)
+
+#define WATERTIGHT_CELLS	(40)	///< Cells along each side of the watertight grid
+#define WATERTIGHT_SEEDS	(20)	///< Jittered grids drawn by checkWatertight
+#define WATERTIGHT_MARGIN	(8)		///< Pixels between the grid and the image edge
+
+/**
+ * \brief Writes image as an uncompressed 24-bit .bmp.
+ * 
+ * \return Returns true if successful, otherwise false
+ */
+const bool writeBMP(const std::string& filename, const GoldenImage& image)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr
+			<< "Error writing image: " << filename
+			<< " -> Could not open file\n";
+		return false;
+	}
+
+	const int rowSize = (3 * image.width + 3) & ~3;
+	const uint32_t dataSize = (uint32_t)(rowSize * image.height);
+
+	uint8 header[BMP_HEADER_SIZE] = {};
+	auto put32 = [&header](const int offset, const uint32_t value)
+	{
+		header[offset + 0] = (uint8)(value >> 0);
+		header[offset + 1] = (uint8)(value >> 8);
+		header[offset + 2] = (uint8)(value >> 16);
+		header[offset + 3] = (uint8)(value >> 24);
+	};
+	header[0] = 'B';
+	header[1] = 'M';
+	put32(2, BMP_HEADER_SIZE + dataSize);
+	put32(10, BMP_HEADER_SIZE);
+	put32(14, 40);
+	put32(18, (uint32_t)image.width);
+	put32(22, (uint32_t)image.height);
+	header[26] = 1;		// planes
+	header[28] = 24;	// bits per pixel
+	put32(34, dataSize);
+	file.write((const char*)header, BMP_HEADER_SIZE);
+
+	// Rows are stored bottom-up as BGR
+	std::vector<uint8> row(rowSize, 0);
+	for (int y = image.height - 1; y >= 0; y--)
+	{
+		for (int x = 0; x < image.width; x++)
+		{
+			const colour_t c = image.pixels[x + y * image.width];
+			row[3 * x + 0] = (uint8)(c >> 0);
+			row[3 * x + 1] = (uint8)(c >> 8);
+			row[3 * x + 2] = (uint8)(c >> 16);
+		}
+		file.write((const char*)row.data(), rowSize);
+	}
+
+	return file.good();
+}
+
+/**
+ * \brief Reads an uncompressed 24-bit .bmp as written by writeBMP.
+ * 
+ * \return Returns true if successful, otherwise false
+ */
+const bool readBMP(const std::string& filename, GoldenImage& image)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr
+			<< "Error reading image: " << filename
+			<< " -> Could not open file\n";
+		return false;
+	}
+
+	uint8 header[BMP_HEADER_SIZE];
+	file.read((char*)header, BMP_HEADER_SIZE);
+	auto get32 = [&header](const int offset)
+	{
+		return (uint32_t)header[offset] | ((uint32_t)header[offset + 1] << 8) |
+			((uint32_t)header[offset + 2] << 16) | ((uint32_t)header[offset + 3] << 24);
+	};
+
+	if (!file.good() || header[0] != 'B' || header[1] != 'M' || header[28] != 24)
+	{
+		std::cerr
+			<< "Error reading image: " << filename
+			<< " -> Not a 24-bit .bmp\n";
+		return false;
+	}
+
+	image.width = (int)get32(18);
+	image.height = (int)get32(22);
+	image.pixels.assign(image.width * image.height, 0);
+	file.seekg(get32(10));
+
+	const int rowSize = (3 * image.width + 3) & ~3;
+	std::vector<uint8> row(rowSize);
+	for (int y = image.height - 1; y >= 0; y--)
+	{
+		file.read((char*)row.data(), rowSize);
+		for (int x = 0; x < image.width; x++)
+		{
+			image.pixels[x + y * image.width] = rgbToHex(row[3 * x + 2], row[3 * x + 1], row[3 * x + 0]);
+		}
+	}
+
+	if (!file.good())
+	{
+		std::cerr
+			<< "Error reading image: " << filename
+			<< " -> File is truncated\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * \brief Canonical scene and how closely it must match its reference.
+ */
+struct GoldenScene
+{
+	std::string name;
+	std::vector<MeshInstance*> objects;	///< Objects to render (owned by scene data)
+	Vec4f vCamera;
+	Vec4f vTarget;
+	int channelTolerance = 0;			///< Maximum difference of any colour channel
+	float maxMismatchFraction = 0.0f;	///< Fraction of pixels allowed to exceed tolerance
+};
+
+/**
+ * \brief Owns everything the golden scenes need.
+ */
+struct GoldenData
+{
+	BenchmarkWorld world;
+	std::unique_ptr<Texture> pTextureGrass;
+	std::unique_ptr<Texture> pTextureStone;
+	std::vector<std::unique_ptr<Mesh>> vMeshes;
+	std::vector<std::unique_ptr<Object>> vObjects;
+	std::vector<GoldenScene> scenes;
+};
+
+/**
+ * \brief Builds the canonical scenes: the test cube, a voxel terrain and an
+ * .obj model.
+ * 
+ * \return Returns true if successful, otherwise false
+ */
+static const bool buildGoldenScenes(const BenchmarkSettings& settings, GoldenData& data)
+{
+	data.pTextureGrass.reset(new Texture(TextureType::RGB, (settings.assetPath + "cubemap_grass.bmp").c_str(), 16, 16));
+	data.pTextureStone.reset(new Texture(TextureType::RGB, (settings.assetPath + "cubemap_stone.bmp").c_str(), 16, 16));
+	if (data.pTextureGrass->data == nullptr || data.pTextureStone->data == nullptr)
+	{
+		std::cerr << "Error building golden scenes -> Could not load textures from "
+			<< settings.assetPath << "\n";
+		return false;
+	}
+
+	/* Test cube, rotated so no edge is axis aligned */
+	{
+		Mesh* mesh = new Mesh();
+		data.vMeshes.emplace_back(mesh);
+		mesh->LoadTestCube("Cube");
+
+		Object* cube = new Object();
+		data.vObjects.emplace_back(cube);
+		cube->pMesh = mesh;
+		cube->pTexture = data.pTextureGrass.get();
+		cube->setPos(0.0f, 0.0f, 0.0f);
+		cube->updatePosition(0.6f);
+
+		GoldenScene scene;
+		scene.name = "cube";
+		scene.objects.push_back(cube);
+		scene.vCamera = Vec4f(1.8f, 1.2f, -1.6f);
+		scene.vTarget = Vec4f(0.3f, 0.3f, 0.3f);
+		scene.maxMismatchFraction = 0.002f;
+		data.scenes.push_back(scene);
+	}
+
+	/* Voxel terrain */
+	{
+		BenchmarkSettings worldSettings = settings;
+		worldSettings.world_num_objects_x = 12;
+		worldSettings.world_num_objects_y = 8;
+		worldSettings.world_num_objects_z = 12;
+		worldSettings.seed = 1;
+		if (!data.world.build(worldSettings))
+		{
+			return false;
+		}
+
+		GoldenScene scene;
+		scene.name = "terrain";
+		scene.objects = data.world.objectsToRender;
+		scene.vCamera = Vec4f(-4.0f, 10.0f, -4.0f);
+		scene.vTarget = Vec4f(6.0f, 3.0f, 6.0f);
+		scene.maxMismatchFraction = 0.002f;
+		data.scenes.push_back(scene);
+	}
+
+	/* .obj model */
+	{
+		Mesh* mesh = new Mesh();
+		data.vMeshes.emplace_back(mesh);
+		if (!mesh->LoadObjectFile(settings.goldenDir + "sphere.obj", true))
+		{
+			return false;
+		}
+
+		Object* model = new Object();
+		data.vObjects.emplace_back(model);
+		model->pMesh = mesh;
+		model->name = "Sphere";
+		model->pTexture = data.pTextureStone.get();
+		model->setPos(0.0f, 0.0f, 0.0f);
+		model->updatePosition(0.4f);
+
+		GoldenScene scene;
+		scene.name = "model";
+		scene.objects.push_back(model);
+		scene.vCamera = Vec4f(0.0f, 0.6f, -2.6f);
+		scene.vTarget = Vec4f(0.0f, 0.0f, 0.0f);
+		scene.maxMismatchFraction = 0.002f;
+		data.scenes.push_back(scene);
+	}
+
+	return true;
+}
+
+/**
+ * \brief Renders scene to gfx.
+ */
+static void renderGoldenScene(OffscreenGraphics& gfx, const GoldenScene& scene)
+{
+	Matrix4x4 projectionMatrix;
+	projectionMatrix.MakeProjection(90.0f, (float)gfx.getHeight() / (float)gfx.getWidth(), 0.1f, 1000.0f);
+
+	const Vec4f vUp = { 0.0f, 1.0f, 0.0f };
+	const Vec4f vLookDir = Vec4f::Normalise(scene.vTarget - scene.vCamera);
+	Matrix4x4 matrixCamera;
+	matrixCamera.MakePointAt(scene.vCamera, scene.vCamera + vLookDir, vUp);
+	matrixCamera.MakeQuickInverse();
+
+	gfx.clearScreen(0xcdcdcd);
+	gfx.clearDepthBuffer();
+
+	ObjectHit objectHit;
+	gfx.rasterTexturedTriangles(projectionMatrix, matrixCamera, scene.vCamera, vLookDir,
+		objectHit, 0.0f, scene.objects, nullptr);
+}
+
+/**
+ * \brief Reads budgets file of "scene milliseconds" lines.
+ */
+static std::map<std::string, float> readBudgets(const std::string& filename)
+{
+	std::map<std::string, float> budgets;
+	std::ifstream file(filename);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream s(line);
+		std::string name;
+		float fMs;
+		if (s >> name >> fMs)
+		{
+			budgets[name] = fMs;
+		}
+	}
+	return budgets;
+}
+
+/**
+ * \brief Writes budgets file read by readBudgets.
+ */
+static const bool writeBudgets(const std::string& filename, const std::map<std::string, float>& budgets)
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cerr
+			<< "Error writing budgets: " << filename
+			<< " -> Could not open file\n";
+		return false;
+	}
+
+	file << "# Median render time in milliseconds per golden scene.\n";
+	file << "# Recorded with: Benchmark --golden-record (release build)\n";
+	for (auto& b : budgets)
+	{
+		file << b.first << " " << b.second << "\n";
+	}
+	return true;
+}
+
+/**
+ * \brief Counts pixels whose channels differ by more than tolerance and 
+ * fills diff with the mismatching pixels in red.
+ */
+static int compareImages(const GoldenImage& actual, const GoldenImage& expected, const int tolerance, GoldenImage& diff)
+{
+	diff = actual;
+	int mismatches = 0;
+	for (size_t i = 0; i < actual.pixels.size(); i++)
+	{
+		const colour_t a = actual.pixels[i];
+		const colour_t b = expected.pixels[i];
+		int worst = 0;
+		for (int shift = 0; shift <= 16; shift += 8)
+		{
+			const int d = abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff));
+			worst = std::max(worst, d);
+		}
+
+		if (worst > tolerance)
+		{
+			mismatches++;
+			diff.pixels[i] = 0xff0000;
+		}
+		else
+		{
+			diff.pixels[i] = (a >> 2) & 0x3f3f3f;  // darkened for context
+		}
+	}
+	return mismatches;
+}
+
+/**
+ * \brief Draws jittered grids of solid triangles which share every edge and
+ * checks each pixel inside the grid is covered exactly once.
+ * 
+ * Border corners stay on the pixel grid and inner corners move by up to a
+ * fifth of a cell, so edges land between pixel centres and on them. The 
+ * top-left rule must neither draw a pixel twice (RasterStats::
+ * pixelsOverdrawn) nor miss one (a hole left at the clear colour).
+ * 
+ * \return Returns true if every grid was watertight, otherwise false
+ */
+static const bool checkWatertight(const BenchmarkSettings& settings)
+{
+	OffscreenGraphics gfx(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+	gfx.rasterOptions.tiledTargets = settings.tiledTargets;
+	gfx.rasterOptions.fastClear = settings.fastClear;
+	gfx.rasterOptions.countOverdraw = true;
+
+	const int n = WATERTIGHT_CELLS;
+	const float x0 = (float)WATERTIGHT_MARGIN, y0 = (float)WATERTIGHT_MARGIN;
+	const float cellW = (float)(GOLDEN_WIDTH - 2 * WATERTIGHT_MARGIN) / n;
+	const float cellH = (float)(GOLDEN_HEIGHT - 2 * WATERTIGHT_MARGIN) / n;
+
+	std::vector<Vec2f> vCorners((n + 1) * (n + 1));
+	std::vector<Triangle> vTriangles;
+	vTriangles.reserve(2 * n * n);
+	uint64_t overdrawn = 0;
+	int holes = 0;
+
+	for (uint32_t seed = 1; seed <= WATERTIGHT_SEEDS; seed++)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+		for (int y = 0; y <= n; y++)
+		{
+			for (int x = 0; x <= n; x++)
+			{
+				const bool inner = x > 0 && x < n && y > 0 && y < n;
+				const float jx = inner ? jitter(rng) * cellW : 0.0f;
+				const float jy = inner ? jitter(rng) * cellH : 0.0f;
+				vCorners[y * (n + 1) + x] = Vec2f(x0 + x * cellW + jx, y0 + y * cellH + jy);
+			}
+		}
+
+		auto addTriangle = [&vTriangles](const Vec2f& a, const Vec2f& b, const Vec2f& c)
+		{
+			Triangle triangle;
+			triangle.p[0] = Vec4f(a.x, a.y, 0.0f);
+			triangle.p[1] = Vec4f(b.x, b.y, 0.0f);
+			triangle.p[2] = Vec4f(c.x, c.y, 0.0f);
+			for (int i = 0; i < 3; i++)
+			{
+				triangle.t[i] = Vec3f(0.0f, 0.0f, 1.0f);
+			}
+			triangle.colour = 0xffffff;
+			vTriangles.push_back(triangle);
+		};
+
+		// Split each cell along alternating diagonals
+		vTriangles.clear();
+		for (int y = 0; y < n; y++)
+		{
+			for (int x = 0; x < n; x++)
+			{
+				const Vec2f& a = vCorners[y * (n + 1) + x];
+				const Vec2f& b = vCorners[y * (n + 1) + x + 1];
+				const Vec2f& c = vCorners[(y + 1) * (n + 1) + x];
+				const Vec2f& d = vCorners[(y + 1) * (n + 1) + x + 1];
+				if ((x + y + seed) & 1)
+				{
+					addTriangle(a, b, d);
+					addTriangle(a, d, c);
+				}
+				else
+				{
+					addTriangle(a, b, c);
+					addTriangle(b, d, c);
+				}
+			}
+		}
+
+		gfx.clearScreen(0);
+		gfx.clearDepthBuffer();
+		gfx.resetRasterStats();
+		gfx.rasterTriangles(vTriangles.data(), vTriangles.size());
+		gfx.resolveRasterTargets();
+		overdrawn += gfx.rasterStats.pixelsOverdrawn;
+
+		const colour_t* pixels = gfx.getPixels();
+		for (int y = WATERTIGHT_MARGIN; y < GOLDEN_HEIGHT - WATERTIGHT_MARGIN; y++)
+		{
+			for (int x = WATERTIGHT_MARGIN; x < GOLDEN_WIDTH - WATERTIGHT_MARGIN; x++)
+			{
+				holes += pixels[x + y * GOLDEN_WIDTH] == 0;
+			}
+		}
+	}
+
+	const bool passed = overdrawn == 0 && holes == 0;
+	std::printf("%-10s %s  %d grids  %llu px overdrawn  %d holes\n", "watertight", passed ? "ok  " : "FAIL",
+		WATERTIGHT_SEEDS, (unsigned long long)overdrawn, holes);
+	return passed;
+}
+
+/**
+ * \brief Renders every golden scene and either records reference images
+ * and budgets (settings.golden == GoldenMode::Record) or checks against 
+ * them.
+ * 
+ * A scene fails if more than maxMismatchFraction of its pixels differ by 
+ * more than channelTolerance, or if its median render time exceeds the 
+ * recorded budget by more than settings.budgetThreshold. Failing scenes 
+ * write <scene>_actual.bmp and <scene>_diff.bmp to the working directory.
+ * checkWatertight runs as a scene named "watertight" with no reference.
+ * 
+ * \return Returns 0 if every scene passed, otherwise -1
+ */
+int runGoldenImages(const BenchmarkSettings& settings)
+{
+	GoldenData data;
+	if (!buildGoldenScenes(settings, data))
+	{
+		return -1;
+	}
+
+	const std::string budgetsFile = settings.goldenDir + "budgets.txt";
+	std::map<std::string, float> budgets = readBudgets(budgetsFile);
+	const bool record = settings.golden == GoldenMode::Record;
+
+	// Memory layout of the targets and the depth prepass must not change
+	// the images; a perspective span over 1 is lossy, so its diffs show how
+	// far affine texturing is off
+	OffscreenGraphics gfx(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+	gfx.rasterOptions.tiledTargets = settings.tiledTargets;
+	gfx.rasterOptions.fastClear = settings.fastClear;
+	gfx.rasterOptions.depthPrepass = settings.depthPrepass;
+	gfx.rasterOptions.perspectiveSpan = settings.perspectiveSpan;
+	bool passed = true;
+
+	for (auto& scene : data.scenes)
+	{
+		if (!settings.filter.empty() && scene.name.find(settings.filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		// Time
+		std::vector<float> vMs;
+		for (int i = 0; i < GOLDEN_TIMED_RUNS; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (int j = 0; j < GOLDEN_RENDERS_PER_RUN; j++)
+			{
+				renderGoldenScene(gfx, scene);
+			}
+			const auto end = std::chrono::steady_clock::now();
+			vMs.push_back(std::chrono::duration<float, std::milli>(end - start).count() / GOLDEN_RENDERS_PER_RUN);
+		}
+		std::sort(vMs.begin(), vMs.end());
+		const float fMedianMs = vMs[vMs.size() / 2];
+
+		GoldenImage actual;
+		actual.width = gfx.getWidth();
+		actual.height = gfx.getHeight();
+		actual.pixels.assign(gfx.getPixels(), gfx.getPixels() + actual.width * actual.height);
+
+		const std::string referenceFile = settings.goldenDir + scene.name + ".bmp";
+		if (record)
+		{
+			budgets[scene.name] = fMedianMs;
+			if (!writeBMP(referenceFile, actual))
+			{
+				passed = false;
+				continue;
+			}
+			std::printf("%-10s recorded  %8.3f ms\n", scene.name.c_str(), fMedianMs);
+			continue;
+		}
+
+		// Compare image
+		bool scenePassed = true;
+		GoldenImage expected;
+		std::string imageResult;
+		if (!readBMP(referenceFile, expected))
+		{
+			scenePassed = false;
+			imageResult = "missing reference";
+		}
+		else if (expected.width != actual.width || expected.height != actual.height)
+		{
+			scenePassed = false;
+			imageResult = "size mismatch";
+		}
+		else
+		{
+			GoldenImage diff;
+			const int mismatches = compareImages(actual, expected, scene.channelTolerance, diff);
+			const int allowed = (int)(scene.maxMismatchFraction * (float)actual.pixels.size());
+			imageResult = std::to_string(mismatches) + "/" + std::to_string(allowed) + " px differ";
+			if (mismatches > allowed)
+			{
+				scenePassed = false;
+				writeBMP(scene.name + "_diff.bmp", diff);
+			}
+		}
+
+		if (!scenePassed)
+		{
+			writeBMP(scene.name + "_actual.bmp", actual);
+		}
+
+		// Compare time
+		std::string timeResult = "no budget";
+		auto budget = budgets.find(scene.name);
+		if (budget != budgets.end() && settings.budgetThreshold >= 0.0f)
+		{
+			const float fLimitMs = budget->second * (1.0f + settings.budgetThreshold);
+			char buffer[64];
+			std::snprintf(buffer, sizeof(buffer), "budget %.3f ms (limit %.3f)", budget->second, fLimitMs);
+			timeResult = buffer;
+			if (fMedianMs > fLimitMs)
+			{
+				scenePassed = false;
+				timeResult += " TOO SLOW";
+			}
+		}
+
+		std::printf("%-10s %s  %8.3f ms  %s  %s\n", scene.name.c_str(), scenePassed ? "ok  " : "FAIL",
+			fMedianMs, imageResult.c_str(), timeResult.c_str());
+		passed = passed && scenePassed;
+	}
+
+	if (settings.filter.empty() || std::string("watertight").find(settings.filter) != std::string::npos)
+	{
+		passed = checkWatertight(settings) && passed;
+	}
+
+	if (record)
+	{
+		return writeBudgets(budgetsFile, budgets) && passed ? 0 : -1;
+	}
+
+	std::printf("%s\n", passed ? "All golden scenes passed" : "Golden scenes FAILED");
+	return passed ? 0 : -1;
+}
@@ -0,0 +1,34 @@
+/*****************************************************************//**
+ * \file   golden.h
+ * \brief  Contains golden image checks: canonical scenes rendered 
+ * headlessly and compared against stored reference images and timing
+ * budgets
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "benchmark.h"
+#include "Engine/types.h"
+#include <string>
+#include <vector>
+
+#define GOLDEN_WIDTH		(256)	///< Width of every golden image
+#define GOLDEN_HEIGHT		(192)	///< Height of every golden image
+#define GOLDEN_TIMED_RUNS	(15)	///< Timed runs per scene, median is compared to budget
+#define GOLDEN_RENDERS_PER_RUN	(20)	///< Renders averaged in each timed run
+
+/**
+ * \brief Image held as colour_t pixels, top row first.
+ */
+struct GoldenImage
+{
+	int width = 0;
+	int height = 0;
+	std::vector<colour_t> pixels;
+};
+
+extern const bool writeBMP(const std::string& filename, const GoldenImage& image);
+extern const bool readBMP(const std::string& filename, GoldenImage& image);
+extern int runGoldenImages(const BenchmarkSettings& settings);
@@ -0,0 +1,241 @@
+/*****************************************************************//**
+ * \file   main.cpp
+ * \brief  Headless flythrough benchmark of the software renderer.
+ * 
+ * Builds a seeded block world like Game::glInit, flies a scripted camera 
+ * through it with Graphics::rasterTexturedTriangles on an offscreen buffer 
+ * and reports frame time percentiles and throughput.
+ * 
+ * Usage: Benchmark [--width N] [--height N] [--size X Y Z] [--seed N]
+ *                  [--frames N] [--warmup N] [--assets DIR]
+ *                  [--csv FILE] [--json FILE] [--label NAME] [--overdraw]
+ *                  [--prepass] [--tiled] [--fast-clear] [--perspective-span N]
+ *        Benchmark --micro [--filter NAME] [--min-time MS] [--csv FILE]
+ *        Benchmark --golden-verify|--golden-record [--golden-dir DIR]
+ *                  [--budget-threshold PERCENT] [--filter NAME]
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#include "Engine/graphics_offscreen.h"
+#include "Engine/utils_vector.h"
+#include "benchmark.h"
+#include "benchmark_world.h"
+#include "golden.h"
+#include "microbench.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#define PI (3.14159f)
+
+/**
+ * \brief Parses command line arguments into settings.
+ * 
+ * \return Returns false if an argument is unknown or missing its value
+ */
+static const bool parseArguments(int argc, char** argv, BenchmarkSettings& settings)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const int remaining = argc - i - 1;
+
+		if (arg == "--width" && remaining >= 1)
+			settings.width = std::atoi(argv[++i]);
+		else if (arg == "--height" && remaining >= 1)
+			settings.height = std::atoi(argv[++i]);
+		else if (arg == "--size" && remaining >= 3)
+		{
+			settings.world_num_objects_x = std::atoi(argv[++i]);
+			settings.world_num_objects_y = std::atoi(argv[++i]);
+			settings.world_num_objects_z = std::atoi(argv[++i]);
+		}
+		else if (arg == "--seed" && remaining >= 1)
+			settings.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--frames" && remaining >= 1)
+			settings.frames = std::atoi(argv[++i]);
+		else if (arg == "--warmup" && remaining >= 1)
+			settings.warmupFrames = std::atoi(argv[++i]);
+		else if (arg == "--assets" && remaining >= 1)
+			settings.assetPath = argv[++i];
+		else if (arg == "--csv" && remaining >= 1)
+			settings.csvFile = argv[++i];
+		else if (arg == "--json" && remaining >= 1)
+			settings.jsonFile = argv[++i];
+		else if (arg == "--label" && remaining >= 1)
+			settings.label = argv[++i];
+		else if (arg == "--overdraw")
+			settings.countOverdraw = true;
+		else if (arg == "--prepass")
+			settings.depthPrepass = true;
+		else if (arg == "--tiled")
+			settings.tiledTargets = true;
+		else if (arg == "--fast-clear")
+			settings.fastClear = true;
+		else if (arg == "--perspective-span" && remaining >= 1)
+			settings.perspectiveSpan = std::atoi(argv[++i]);
+		else if (arg == "--micro")
+			settings.micro = true;
+		else if (arg == "--filter" && remaining >= 1)
+			settings.filter = argv[++i];
+		else if (arg == "--min-time" && remaining >= 1)
+			settings.minTimeMs = (float)std::atof(argv[++i]);
+		else if (arg == "--golden-verify")
+			settings.golden = GoldenMode::Verify;
+		else if (arg == "--golden-record")
+			settings.golden = GoldenMode::Record;
+		else if (arg == "--golden-dir" && remaining >= 1)
+			settings.goldenDir = argv[++i];
+		else if (arg == "--budget-threshold" && remaining >= 1)
+			settings.budgetThreshold = (float)std::atof(argv[++i]) / 100.0f;
+		else
+		{
+			std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+			return false;
+		}
+	}
+
+	if (settings.width <= 0 || settings.height <= 0 || settings.frames <= 0 ||
+		settings.world_num_objects_x <= 0 || settings.world_num_objects_y <= 0 || settings.world_num_objects_z <= 0)
+	{
+		std::cerr << "Invalid settings -> sizes and frames must be positive\n";
+		return false;
+	}
+
+	if (!settings.assetPath.empty() && settings.assetPath.back() != '/' && settings.assetPath.back() != '\\')
+	{
+		settings.assetPath += "/";
+	}
+
+	if (!settings.goldenDir.empty() && settings.goldenDir.back() != '/' && settings.goldenDir.back() != '\\')
+	{
+		settings.goldenDir += "/";
+	}
+
+	return true;
+}
+
+/**
+ * \brief Returns camera position and look direction at t along the path.
+ * 
+ * The path makes one lap around the world while sweeping between a high 
+ * overview outside the world and a low pass over the terrain, so every run 
+ * sees both wide views and close-up faces.
+ * 
+ * \param t Position along path (0.0f - 1.0f)
+ */
+static void cameraAt(const BenchmarkWorld& world, const float t, Vec4f& vCamera, Vec4f& vLookDir)
+{
+	const float sizeX = (float)world.getSizeX();
+	const float sizeY = (float)world.getSizeY();
+	const float sizeZ = (float)world.getSizeZ();
+	const float angle = 2.0f * PI * t;
+	const float sweep = 0.5f + 0.5f * cosf(2.0f * angle);  // 1: outside, 0: inside
+	const float radius = (sizeX > sizeZ ? sizeX : sizeZ) * (0.2f + 0.6f * sweep);
+
+	vCamera = Vec4f(
+		sizeX * 0.5f + radius * cosf(angle),
+		sizeY * (0.8f + 0.4f * sweep),
+		sizeZ * 0.5f + radius * sinf(angle));
+
+	const Vec4f vTarget(sizeX * 0.5f, sizeY * 0.4f, sizeZ * 0.5f);
+	vLookDir = Vec4f::Normalise(vTarget - vCamera);
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+	if (!parseArguments(argc, argv, settings))
+	{
+		return -1;
+	}
+
+	if (settings.micro)
+	{
+		return runMicroBenchmarks(settings);
+	}
+
+	if (settings.golden != GoldenMode::None)
+	{
+		return runGoldenImages(settings);
+	}
+
+	BenchmarkWorld world;
+	if (!world.build(settings))
+	{
+		return -1;
+	}
+
+	OffscreenGraphics gfx(settings.width, settings.height);
+	gfx.rasterOptions.countOverdraw = settings.countOverdraw;
+	gfx.rasterOptions.depthPrepass = settings.depthPrepass;
+	gfx.rasterOptions.tiledTargets = settings.tiledTargets;
+	gfx.rasterOptions.fastClear = settings.fastClear;
+	gfx.rasterOptions.perspectiveSpan = settings.perspectiveSpan;
+
+	Matrix4x4 projectionMatrix;
+	projectionMatrix.MakeProjection(
+		90.0f,
+		(float)settings.height / (float)settings.width,
+		0.1f,
+		1000.0f);
+
+	const Vec4f vUp = { 0.0f, 1.0f, 0.0f };
+	BenchmarkResult result;
+	result.vFrameMs.reserve(settings.frames);
+
+	for (int frame = -settings.warmupFrames; frame < settings.frames; frame++)
+	{
+		if (frame == 0)
+		{
+			gfx.resetRasterStats();
+		}
+
+		const float t = (float)(frame < 0 ? 0 : frame) / (float)settings.frames;
+		Vec4f vCamera, vLookDir;
+		cameraAt(world, t, vCamera, vLookDir);
+
+		Matrix4x4 matrixCamera;
+		matrixCamera.MakePointAt(vCamera, vCamera + vLookDir, vUp);
+		matrixCamera.MakeQuickInverse();
+
+		const auto start = std::chrono::steady_clock::now();
+
+		gfx.clearScreen(0xcdcdcd);
+		gfx.clearDepthBuffer();
+
+		ObjectHit objectHit;
+		gfx.rasterTexturedTriangles(projectionMatrix, matrixCamera, vCamera, vLookDir,
+			objectHit, 5.0f, world.objectsToRender, nullptr);
+
+		const auto end = std::chrono::steady_clock::now();
+
+		if (frame >= 0)
+		{
+			result.vFrameMs.push_back(std::chrono::duration<float, std::milli>(end - start).count());
+		}
+	}
+
+	result.trianglesSubmitted = gfx.rasterStats.trianglesSubmitted;
+	result.trianglesRasterised = gfx.rasterStats.trianglesRasterised;
+	result.pixelsTested = gfx.rasterStats.pixelsTested;
+	result.pixelsWritten = gfx.rasterStats.pixelsWritten;
+	result.pixelsOverdrawn = gfx.rasterStats.pixelsOverdrawn;
+	result.trianglesHidden = gfx.rasterStats.trianglesHidden;
+	result.verticesTransformed = gfx.rasterStats.verticesTransformed;
+	result.peakMemoryBytes = getPeakMemoryBytes();
+	computeStats(result);
+
+	printResult(settings, result);
+	if (!appendCSV(settings, result) || !writeJSON(settings, result))
+	{
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include "microbench.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+/**
+ * \brief Returns every registered kernel, in registration order.
+ */
+std::vector<MicroBenchmark*>& MicroBenchmark::registry()
+{
+	static std::vector<MicroBenchmark*> benchmarks;
+	return benchmarks;
+}
+
+/**
+ * \brief Registers a kernel. Called through MICRO_BENCHMARK.
+ */
+MicroBenchmark* MicroBenchmark::add(const char* name, MicroFunction function)
+{
+	MicroBenchmark* benchmark = new MicroBenchmark(name, function);
+	registry().push_back(benchmark);
+	return benchmark;
+}
+
+/**
+ * \brief Result of one kernel with one set of arguments.
+ */
+struct MicroResult
+{
+	std::string name;
+	int64_t iterations;
+	double nsPerIteration;
+	double itemsPerSecond;
+};
+
+/**
+ * \brief Runs a kernel with growing iteration counts until a single run 
+ * lasts at least minTimeMs, like Google Benchmark.
+ */
+static MicroResult runMicroBenchmark(const MicroBenchmark& benchmark, const std::vector<int>& vArgs, const float minTimeMs)
+{
+	const int64_t minTimeNs = (int64_t)(minTimeMs * 1e6f);
+	int64_t iterations = 1;
+
+	while (true)
+	{
+		MicroState state(vArgs, iterations);
+		benchmark.function(state);
+
+		const int64_t elapsedNs = state.getElapsedNs() > 0 ? state.getElapsedNs() : 1;
+		if (elapsedNs >= minTimeNs || iterations >= ((int64_t)1 << 40))
+		{
+			MicroResult result;
+			result.name = benchmark.name;
+			if (!state.label.empty())
+			{
+				result.name += "/" + state.label;
+			}
+			else
+			{
+				for (auto a : vArgs)
+				{
+					result.name += "/" + std::to_string(a);
+				}
+			}
+			result.iterations = iterations;
+			result.nsPerIteration = (double)elapsedNs / (double)iterations;
+			result.itemsPerSecond = (double)state.itemsProcessed * 1e9 / (double)elapsedNs;
+			return result;
+		}
+
+		// Aim for 1.4x the minimum time, growing at most 10x per attempt
+		double multiplier = (double)minTimeNs * 1.4 / (double)elapsedNs;
+		if (multiplier > 10.0)
+		{
+			multiplier = 10.0;
+		}
+		if (multiplier < 2.0)
+		{
+			multiplier = 2.0;
+		}
+		iterations = (int64_t)((double)iterations * multiplier);
+	}
+}
+
+/**
+ * \brief Runs every registered kernel whose name contains settings.filter
+ * and prints a table of results. Results are also written to 
+ * settings.csvFile if given.
+ * 
+ * \return Returns 0 if successful, otherwise -1
+ */
+int runMicroBenchmarks(const BenchmarkSettings& settings)
+{
+	std::vector<MicroResult> results;
+
+	std::printf("%-52s %14s %14s %16s\n", "Benchmark", "Time (ns)", "Iterations", "Items/s");
+	std::printf("%s\n", std::string(99, '-').c_str());
+
+	for (auto benchmark : MicroBenchmark::registry())
+	{
+		if (!settings.filter.empty() && benchmark->name.find(settings.filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		std::vector<std::vector<int>> vArgs = benchmark->vArgs;
+		if (vArgs.empty())
+		{
+			vArgs.push_back({});
+		}
+
+		for (auto& args : vArgs)
+		{
+			MicroResult result = runMicroBenchmark(*benchmark, args, settings.minTimeMs);
+			std::printf("%-52s %14.1f %14lld %16.4g\n",
+				result.name.c_str(), result.nsPerIteration, (long long)result.iterations, result.itemsPerSecond);
+			results.push_back(result);
+		}
+	}
+
+	if (!settings.csvFile.empty())
+	{
+		std::ofstream file(settings.csvFile);
+		if (!file.is_open())
+		{
+			std::cerr
+				<< "Error writing results: " << settings.csvFile
+				<< " -> Could not open file\n";
+			return -1;
+		}
+
+		file << "label,benchmark,ns_per_iteration,iterations,items_per_second\n";
+		for (auto& r : results)
+		{
+			file << settings.label << "," << r.name << "," << r.nsPerIteration << ","
+				<< r.iterations << "," << r.itemsPerSecond << "\n";
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*****************************************************************//**
+ * \file   microbench.h
+ * \brief  Contains a small Google-Benchmark style registry and runner for
+ * timing individual engine kernels
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "benchmark.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Registers a kernel function void(MicroState&) with the runner.
+ * 
+ * Arguments are added by chaining, e.g. 
+ * MICRO_BENCHMARK(BM_clearScreen)->args({ 640, 480 })->args({ 1280, 720 });
+ */
+#define MICRO_CONCAT_(a, b) a##b
+#define MICRO_CONCAT(a, b) MICRO_CONCAT_(a, b)
+#define MICRO_BENCHMARK(fn) \
+	static MicroBenchmark* MICRO_CONCAT(microBenchmark_, __LINE__) = MicroBenchmark::add(#fn, fn)
+
+/**
+ * \brief Prevents the compiler from optimising away a value that is 
+ * otherwise unused, by folding its bytes into a volatile.
+ * 
+ * \note Call on an accumulated result after the timed loop where possible.
+ */
+template <typename T>
+inline void doNotOptimise(const T& value)
+{
+	static volatile uint8 sink;
+	const uint8* bytes = reinterpret_cast<const uint8*>(&value);
+	uint8 x = 0;
+	for (size_t i = 0; i < sizeof(T); i++)
+	{
+		x ^= bytes[i];
+	}
+	sink = x;
+	(void)sink;
+}
+
+/**
+ * \brief Passed to each kernel. Controls the timed loop and collects 
+ * throughput counters.
+ * 
+ * Kernels do their setup first and then loop with 
+ * while (state.keepRunning()) { ... }. Only the loop is timed.
+ */
+class MicroState
+{
+private:
+	const std::vector<int>& vArgs;
+	int64_t iterations;
+	int64_t remaining;
+	std::chrono::steady_clock::time_point start;
+	int64_t elapsedNs = 0;
+	bool started = false;
+
+public:
+	int64_t itemsProcessed = 0;		///< Items (pixels, triangles, ...) processed in total
+	std::string label;				///< Describes the arguments in reports
+
+	MicroState(const std::vector<int>& vArgs, const int64_t iterations)
+		: vArgs(vArgs), iterations(iterations), remaining(iterations) {}
+
+	int arg(const size_t i) const { return i < vArgs.size() ? vArgs[i] : 0; }
+	int64_t getIterations() const { return iterations; }
+	int64_t getElapsedNs() const { return elapsedNs; }
+
+	inline bool keepRunning()
+	{
+		if (!started)
+		{
+			started = true;
+			start = std::chrono::steady_clock::now();
+		}
+		if (remaining-- > 0)
+		{
+			return true;
+		}
+		elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count();
+		return false;
+	}
+};
+
+typedef void (*MicroFunction)(MicroState&);
+
+/**
+ * \brief A registered kernel and the argument sets to run it with.
+ */
+class MicroBenchmark
+{
+public:
+	std::string name;
+	MicroFunction function;
+	std::vector<std::vector<int>> vArgs;
+
+	MicroBenchmark(const char* name, MicroFunction function) : name(name), function(function) {}
+
+	MicroBenchmark* args(const std::vector<int>& a)
+	{
+		vArgs.push_back(a);
+		return this;
+	}
+
+	static MicroBenchmark* add(const char* name, MicroFunction function);
+	static std::vector<MicroBenchmark*>& registry();
+};
+
+extern int runMicroBenchmarks(const BenchmarkSettings& settings);
@@ -0,0 +1,1075 @@
+/*****************************************************************//**
+ * \file   microbench_kernels.cpp
+ * \brief  Micro-benchmarks of the engine's inner loops
+ * 
+ * Each kernel is parameterised with MICRO_BENCHMARK(...)->args({ ... }) 
+ * and run with: Benchmark --micro [--filter NAME] [--min-time MS]
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#include "microbench.h"
+#include "Engine/graphics_offscreen.h"
+#include "Engine/graphics_commands.h"
+#include "Engine/graphics_compositor.h"
+#include "Engine/graphics_objects.h"
+#include "Engine/graphics_objloader.h"
+#include "Engine/graphics_renderqueue.h"
+#include "Engine/utils_vector.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#define MICRO_SCREEN_WIDTH	(1280)
+#define MICRO_SCREEN_HEIGHT	(720)
+
+/**
+ * \brief Triangle shapes used to parameterise the rasterisers.
+ */
+enum MicroOrientation
+{
+	FlatBottom = 0,		///< Apex pointing up, horizontal bottom edge
+	FlatTop = 1,		///< Apex pointing down, horizontal top edge
+	General = 2,		///< No horizontal edges, split in two by rasterisers
+	Sliver = 3,			///< Long and thin, mostly short spans
+};
+
+static const char* orientationName(const int orientation)
+{
+	switch (orientation)
+	{
+	case FlatBottom:	return "flat_bottom";
+	case FlatTop:		return "flat_top";
+	case General:		return "general";
+	case Sliver:		return "sliver";
+	}
+	return "unknown";
+}
+
+/**
+ * \brief Returns screen space corners of a triangle of the given bounding 
+ * size and orientation, centred on screen.
+ */
+static void makeTriangle(const int size, const int orientation, Vec2f out[3])
+{
+	const float cx = MICRO_SCREEN_WIDTH * 0.5f;
+	const float cy = MICRO_SCREEN_HEIGHT * 0.5f;
+	const float h = size * 0.5f;
+
+	switch (orientation)
+	{
+	case FlatBottom:
+		out[0] = Vec2f(cx, cy - h);
+		out[1] = Vec2f(cx - h, cy + h);
+		out[2] = Vec2f(cx + h, cy + h);
+		break;
+	case FlatTop:
+		out[0] = Vec2f(cx - h, cy - h);
+		out[1] = Vec2f(cx + h, cy - h);
+		out[2] = Vec2f(cx, cy + h);
+		break;
+	case General:
+		out[0] = Vec2f(cx - h * 0.3f, cy - h);
+		out[1] = Vec2f(cx - h, cy + h * 0.4f);
+		out[2] = Vec2f(cx + h, cy + h);
+		break;
+	default:
+		out[0] = Vec2f(cx - h, cy - h);
+		out[1] = Vec2f(cx - h + 3.0f, cy - h);
+		out[2] = Vec2f(cx + h, cy + h);
+		break;
+	}
+}
+
+/**
+ * \brief Returns the area of a triangle in pixels.
+ */
+static float triangleArea(const Vec2f v[3])
+{
+	const float area = ((v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y)) * 0.5f;
+	return area < 0.0f ? -area : area;
+}
+
+/**
+ * \brief Creates a square RGB checkerboard texture, stored like a loaded
+ * 24-bit .bmp.
+ */
+static Texture* makeCheckerTexture(const int size)
+{
+	Texture* texture = new Texture(TextureType::RGB, size, size, size, size);
+	uint8* data = reinterpret_cast<uint8*>(texture->data);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			const bool light = ((x / 4) + (y / 4)) % 2 == 0;
+			uint8* pixel = &data[3 * (y * size + x)];
+			pixel[0] = light ? 0xe0 : 0x20;
+			pixel[1] = (uint8)(x * 255 / size);
+			pixel[2] = (uint8)(y * 255 / size);
+		}
+	}
+	return texture;
+}
+
+/**
+ * \brief Screen shared by kernels which draw.
+ */
+static OffscreenGraphics& microGraphics()
+{
+	static OffscreenGraphics gfx(MICRO_SCREEN_WIDTH, MICRO_SCREEN_HEIGHT);
+	return gfx;
+}
+
+/**
+ * \brief drawTexturedTriangle. Args: size (px), orientation, texture size.
+ * 
+ * The depth of the triangle grows every iteration so every pixel passes 
+ * the depth test, as when drawing a new surface in front.
+ */
+static void BM_drawTexturedTriangle(MicroState& state)
+{
+	const int size = state.arg(0);
+	const int orientation = state.arg(1);
+	const int textureSize = state.arg(2);
+
+	OffscreenGraphics& gfx = microGraphics();
+	gfx.clearDepthBuffer();
+
+	std::unique_ptr<Texture> texture(makeCheckerTexture(textureSize));
+	Object object;
+	object.pTexture = texture.get();
+
+	Vec2f corners[3];
+	makeTriangle(size, orientation, corners);
+	const Vec3f uv[3] = { Vec3f(0.0f, 0.0f), Vec3f(0.0f, 0.99f), Vec3f(0.99f, 0.99f) };
+
+	Triangle triangle;
+	triangle.parent = &object;
+	float w = 1.0f;
+
+	while (state.keepRunning())
+	{
+		w += 0.001f;
+		if (w > 1000.0f)
+		{
+			w = 1.0f;
+			gfx.clearDepthBuffer();
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			triangle.p[i] = Vec4f(corners[i].x, corners[i].y, 0.0f);
+			triangle.t[i] = Vec3f(uv[i].u * w, uv[i].v * w, w);
+		}
+		gfx.drawTexturedTriangle(triangle);
+	}
+
+	state.itemsProcessed = (int64_t)gfx.rasterStats.pixelsWritten;
+	gfx.resetRasterStats();
+	state.label = "size:" + std::to_string(size) + "/" + orientationName(orientation) +
+		"/tex:" + std::to_string(textureSize);
+}
+MICRO_BENCHMARK(BM_drawTexturedTriangle)
+	->args({ 8, General, 64 })
+	->args({ 32, General, 64 })
+	->args({ 128, General, 64 })
+	->args({ 512, General, 64 })
+	->args({ 2048, General, 64 })
+	->args({ 128, FlatBottom, 64 })
+	->args({ 128, FlatTop, 64 })
+	->args({ 128, Sliver, 64 })
+	->args({ 128, General, 16 })
+	->args({ 128, General, 256 })
+	->args({ 512, General, 1024 });
+
+/**
+ * \brief rasterTriangles of many small textured triangles, as distant faces
+ * of a wide outdoor view. Args: largest size (px).
+ * 
+ * Triangles are spread across the screen in order, with random shapes and 
+ * corners in any winding. Depth testing is off so every covered pixel is 
+ * drawn each iteration. Items are triangles.
+ */
+static void BM_rasterSmallTriangles(MicroState& state)
+{
+	const int size = state.arg(0);
+
+	OffscreenGraphics& gfx = microGraphics();
+	std::unique_ptr<Texture> texture(makeCheckerTexture(64));
+	Object object;
+	object.pTexture = texture.get();
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> offset(0.0f, (float)size);
+	std::uniform_real_distribution<float> depth(0.2f, 2.0f);
+	std::vector<Triangle> vTriangles(10000);
+	for (size_t i = 0; i < vTriangles.size(); i++)
+	{
+		const float x = (float)((i * 3) % (MICRO_SCREEN_WIDTH - 16)) + 4.0f;
+		const float y = (float)((i * 3) / (MICRO_SCREEN_WIDTH - 16) * 3 % (MICRO_SCREEN_HEIGHT - 16)) + 4.0f;
+		Triangle& t = vTriangles[i];
+		t.parent = &object;
+		for (int k = 0; k < 3; k++)
+		{
+			const float w = depth(rng);
+			t.p[k] = Vec4f(x + offset(rng), y + offset(rng), 0.0f);
+			t.t[k] = Vec3f((float)(k & 1) * w, (float)(k >> 1) * w, w);
+		}
+	}
+
+	gfx.rasterOptions.depthTest = false;
+	while (state.keepRunning())
+	{
+		gfx.rasterTriangles(vTriangles.data(), vTriangles.size());
+	}
+	gfx.rasterOptions.depthTest = true;
+
+	state.itemsProcessed = state.getIterations() * (int64_t)vTriangles.size();
+	gfx.resetRasterStats();
+	state.label = "size:" + std::to_string(size);
+}
+MICRO_BENCHMARK(BM_rasterSmallTriangles)
+	->args({ 1 })
+	->args({ 2 })
+	->args({ 4 })
+	->args({ 8 });
+
+/**
+ * \brief rasterTriangles of textured triangles hidden behind a wall which
+ * covers the screen, drawn first. Args: RasterOptions::depthBounds.
+ *
+ * Items are hidden triangles, the label counts those skipped by tile depth
+ * bounds without testing any pixel.
+ */
+static void BM_rasterHiddenTriangles(MicroState& state)
+{
+	const bool depthBounds = state.arg(0) != 0;
+
+	OffscreenGraphics& gfx = microGraphics();
+	std::unique_ptr<Texture> texture(makeCheckerTexture(64));
+	Object object;
+	object.pTexture = texture.get();
+
+	const float wallW = 1.0f;
+	const float wallX = (float)MICRO_SCREEN_WIDTH, wallY = (float)MICRO_SCREEN_HEIGHT;
+	Triangle wall[2];
+	wall[0].p[0] = Vec4f(0.0f, 0.0f, 0.0f);
+	wall[0].p[1] = Vec4f(wallX, 0.0f, 0.0f);
+	wall[0].p[2] = Vec4f(wallX, wallY, 0.0f);
+	wall[1].p[0] = Vec4f(0.0f, 0.0f, 0.0f);
+	wall[1].p[1] = Vec4f(wallX, wallY, 0.0f);
+	wall[1].p[2] = Vec4f(0.0f, wallY, 0.0f);
+	for (int n = 0; n < 2; n++)
+	{
+		wall[n].parent = &object;
+		for (int k = 0; k < 3; k++)
+		{
+			wall[n].t[k] = Vec3f(wall[n].p[k].x / wallX * wallW, wall[n].p[k].y / wallY * wallW, wallW);
+		}
+	}
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position(0.0f, 1.0f);
+	std::uniform_real_distribution<float> offset(-32.0f, 32.0f);
+	std::uniform_real_distribution<float> depth(0.2f, 0.9f);
+	std::vector<Triangle> vTriangles(2000);
+	for (auto& t : vTriangles)
+	{
+		const float x = position(rng) * MICRO_SCREEN_WIDTH;
+		const float y = position(rng) * MICRO_SCREEN_HEIGHT;
+		t.parent = &object;
+		for (int k = 0; k < 3; k++)
+		{
+			const float w = depth(rng);
+			t.p[k] = Vec4f(x + offset(rng), y + offset(rng), 0.0f);
+			t.t[k] = Vec3f((float)(k & 1) * w, (float)(k >> 1) * w, w);
+		}
+	}
+
+	gfx.rasterOptions.depthBounds = depthBounds;
+	gfx.clearDepthBuffer();
+	gfx.rasterTriangles(wall, 2);
+	gfx.resetRasterStats();
+	while (state.keepRunning())
+	{
+		gfx.rasterTriangles(vTriangles.data(), vTriangles.size());
+	}
+	const uint64_t hidden = gfx.rasterStats.trianglesHidden / state.getIterations();
+	gfx.rasterOptions.depthBounds = true;
+	gfx.clearDepthBuffer();
+
+	state.itemsProcessed = state.getIterations() * (int64_t)vTriangles.size();
+	gfx.resetRasterStats();
+	state.label = std::string(depthBounds ? "bounds" : "no_bounds")
+		+ " skipped:" + std::to_string(hidden) + "/" + std::to_string(vTriangles.size());
+}
+MICRO_BENCHMARK(BM_rasterHiddenTriangles)
+	->args({ 0 })
+	->args({ 1 });
+
+/**
+ * \brief Frame of overlapping textured triangles drawn back to front, the
+ * worst order for the depth test. Args: depth prepass (rasterDepth).
+ *
+ * Items are triangles, the label counts texels written per pixel covered.
+ */
+static void BM_rasterDepthPrepass(MicroState& state)
+{
+	const bool prepass = state.arg(0) != 0;
+
+	OffscreenGraphics& gfx = microGraphics();
+	std::unique_ptr<Texture> texture(makeCheckerTexture(64));
+	Object object;
+	object.pTexture = texture.get();
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position(0.25f, 0.75f);
+	std::uniform_real_distribution<float> offset(-200.0f, 200.0f);
+	std::vector<Triangle> vTriangles(400);
+	for (size_t i = 0; i < vTriangles.size(); i++)
+	{
+		const float x = position(rng) * MICRO_SCREEN_WIDTH;
+		const float y = position(rng) * MICRO_SCREEN_HEIGHT;
+		const float w = 0.2f + 0.002f * (float)i;
+		Triangle& t = vTriangles[i];
+		t.parent = &object;
+		for (int k = 0; k < 3; k++)
+		{
+			t.p[k] = Vec4f(x + offset(rng), y + offset(rng), 0.0f);
+			t.t[k] = Vec3f((float)(k & 1) * w, (float)(k >> 1) * w, w);
+		}
+	}
+
+	while (state.keepRunning())
+	{
+		gfx.clearDepthBuffer();
+		gfx.resetRasterStats();
+		if (prepass)
+		{
+			gfx.rasterDepth(vTriangles.data(), vTriangles.size());
+			gfx.resetRasterStats();
+		}
+		gfx.rasterTriangles(vTriangles.data(), vTriangles.size(), nullptr, prepass);
+	}
+
+	// Texels written by the colour pass of the last frame, per pixel covered
+	const uint64_t texels = gfx.rasterStats.pixelsWritten;
+	uint64_t covered = 0;
+	for (int i = 0; i < MICRO_SCREEN_WIDTH * MICRO_SCREEN_HEIGHT; i++)
+	{
+		covered += gfx.getDepth()[i] > 0.0f;
+	}
+	gfx.clearDepthBuffer();
+	gfx.resetRasterStats();
+
+	char ratio[32];
+	std::snprintf(ratio, sizeof(ratio), "%.2f", covered > 0 ? (double)texels / (double)covered : 0.0);
+	state.itemsProcessed = state.getIterations() * (int64_t)vTriangles.size();
+	state.label = std::string(prepass ? "prepass" : "no_prepass") + " texels/px:" + ratio;
+}
+MICRO_BENCHMARK(BM_rasterDepthPrepass)
+	->args({ 0 })
+	->args({ 1 });
+
+/**
+ * \brief Frame of tall, narrow textured triangles (as of walls seen edge 
+ * on), which step a whole row of the buffer per pixel down. Args: 
+ * RasterOptions::tiledTargets.
+ *
+ * Items are triangles, the tiled frame includes resolveRasterTargets.
+ */
+static void BM_rasterTiledTargets(MicroState& state)
+{
+	const bool tiled = state.arg(0) != 0;
+
+	OffscreenGraphics& gfx = microGraphics();
+	gfx.rasterOptions.tiledTargets = tiled;
+	std::unique_ptr<Texture> texture(makeCheckerTexture(64));
+	Object object;
+	object.pTexture = texture.get();
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position(0.0f, 1.0f);
+	std::vector<Triangle> vTriangles(200);
+	for (size_t i = 0; i < vTriangles.size(); i++)
+	{
+		const float x = position(rng) * (MICRO_SCREEN_WIDTH - 12.0f);
+		const float w = 0.2f + 0.004f * (float)i;
+		Triangle& t = vTriangles[i];
+		t.parent = &object;
+		t.p[0] = Vec4f(x, 0.0f, 0.0f);
+		t.p[1] = Vec4f(x + 12.0f, 0.0f, 0.0f);
+		t.p[2] = Vec4f(x + 6.0f, (float)MICRO_SCREEN_HEIGHT, 0.0f);
+		for (int k = 0; k < 3; k++)
+		{
+			t.t[k] = Vec3f((float)(k & 1) * w, (float)(k >> 1) * w, w);
+		}
+	}
+
+	while (state.keepRunning())
+	{
+		gfx.clearDepthBuffer();
+		gfx.rasterTriangles(vTriangles.data(), vTriangles.size());
+		gfx.resolveRasterTargets();
+	}
+
+	gfx.rasterOptions.tiledTargets = false;
+	gfx.clearDepthBuffer();
+	gfx.resetRasterStats();
+	state.itemsProcessed = state.getIterations() * (int64_t)vTriangles.size();
+	state.label = tiled ? "tiled" : "linear";
+}
+MICRO_BENCHMARK(BM_rasterTiledTargets)
+	->args({ 0 })
+	->args({ 1 });
+
+/**
+ * \brief drawTexturedTriangle of a surface seen at a steep angle. Args: 
+ * size (px), RasterOptions::perspectiveSpan.
+ * 
+ * The label counts pixels which differ from exact (span 0) texturing.
+ */
+static void BM_drawTexturedTrianglePerspective(MicroState& state)
+{
+	const int size = state.arg(0);
+	const int span = state.arg(1);
+
+	OffscreenGraphics& gfx = microGraphics();
+	std::unique_ptr<Texture> texture(makeCheckerTexture(64));
+	Object object;
+	object.pTexture = texture.get();
+
+	Vec2f corners[3];
+	makeTriangle(size, General, corners);
+	const Vec3f uv[3] = { Vec3f(0.0f, 0.0f), Vec3f(0.0f, 0.99f), Vec3f(0.99f, 0.99f) };
+	const float depth[3] = { 1.0f, 0.2f, 0.5f };
+
+	Triangle triangle;
+	triangle.parent = &object;
+	auto setDepth = [&](const float w)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			triangle.p[i] = Vec4f(corners[i].x, corners[i].y, 0.0f);
+			triangle.t[i] = Vec3f(uv[i].u * depth[i] * w, uv[i].v * depth[i] * w, depth[i] * w);
+		}
+	};
+
+	// Exact image to compare against
+	const size_t numPixels = (size_t)MICRO_SCREEN_WIDTH * MICRO_SCREEN_HEIGHT;
+	setDepth(1.0f);
+	gfx.clearScreen(0);
+	gfx.clearDepthBuffer();
+	gfx.rasterOptions.perspectiveSpan = 0;
+	gfx.drawTexturedTriangle(triangle);
+	const std::vector<colour_t> vExact(gfx.getPixels(), gfx.getPixels() + numPixels);
+
+	gfx.clearScreen(0);
+	gfx.clearDepthBuffer();
+	gfx.rasterOptions.perspectiveSpan = span;
+	gfx.drawTexturedTriangle(triangle);
+	int differ = 0;
+	for (size_t i = 0; i < numPixels; i++)
+	{
+		differ += gfx.getPixels()[i] != vExact[i];
+	}
+
+	gfx.clearDepthBuffer();
+	gfx.resetRasterStats();
+	float w = 1.0f;
+
+	while (state.keepRunning())
+	{
+		w += 0.001f;
+		if (w > 1000.0f)
+		{
+			w = 1.0f;
+			gfx.clearDepthBuffer();
+		}
+
+		setDepth(w);
+		gfx.drawTexturedTriangle(triangle);
+	}
+
+	state.itemsProcessed = (int64_t)gfx.rasterStats.pixelsWritten;
+	gfx.resetRasterStats();
+	gfx.rasterOptions.perspectiveSpan = 0;
+	state.label = "size:" + std::to_string(size) + "/span:" + std::to_string(span) + 
+		"/differ:" + std::to_string(differ);
+}
+MICRO_BENCHMARK(BM_drawTexturedTrianglePerspective)
+	->args({ 128, 0 })
+	->args({ 128, 8 })
+	->args({ 128, 16 })
+	->args({ 512, 0 })
+	->args({ 512, 8 })
+	->args({ 512, 16 })
+	->args({ 512, 32 })
+	->args({ 2048, 0 })
+	->args({ 2048, 16 });
+
+/**
+ * \brief fillTriangleP. Args: size (px), orientation.
+ */
+static void BM_fillTriangleP(MicroState& state)
+{
+	const int size = state.arg(0);
+	const int orientation = state.arg(1);
+
+	OffscreenGraphics& gfx = microGraphics();
+	Vec2f corners[3];
+	makeTriangle(size, orientation, corners);
+
+	while (state.keepRunning())
+	{
+		Vec2 v1 = { (int)corners[0].x, (int)corners[0].y };
+		Vec2 v2 = { (int)corners[1].x, (int)corners[1].y };
+		Vec2 v3 = { (int)corners[2].x, (int)corners[2].y };
+		gfx.fillTriangleP(v1, v2, v3, 0xff8000);
+	}
+
+	state.itemsProcessed = state.getIterations() * (int64_t)triangleArea(corners);
+	state.label = "size:" + std::to_string(size) + "/" + orientationName(orientation);
+}
+MICRO_BENCHMARK(BM_fillTriangleP)
+	->args({ 8, General })
+	->args({ 32, General })
+	->args({ 128, General })
+	->args({ 512, General })
+	->args({ 128, FlatBottom })
+	->args({ 128, FlatTop })
+	->args({ 128, Sliver });
+
+/**
+ * \brief Graphics::fillTriangle (solid colour, depth tested). Args: size 
+ * (px), orientation. Each iteration is drawn nearer than the last so every
+ * pixel passes.
+ */
+static void BM_fillTriangleDepth(MicroState& state)
+{
+	const int size = state.arg(0);
+	const int orientation = state.arg(1);
+
+	OffscreenGraphics& gfx = microGraphics();
+	Vec2f corners[3];
+	makeTriangle(size, orientation, corners);
+
+	Triangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		triangle.p[i] = Vec4f(corners[i].x, corners[i].y, 0.0f);
+	}
+
+	gfx.clearDepthBuffer();
+	float base = 1.0f;
+	while (state.keepRunning())
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			triangle.t[i].w = base + 0.001f * i;
+		}
+		gfx.fillTriangle(triangle, 0xff8000);
+
+		base += 1.0f / 256.0f;
+		if (base > 1024.0f)
+		{
+			gfx.clearDepthBuffer();
+			base = 1.0f;
+		}
+	}
+
+	state.itemsProcessed = state.getIterations() * (int64_t)triangleArea(corners);
+	state.label = "size:" + std::to_string(size) + "/" + orientationName(orientation);
+}
+MICRO_BENCHMARK(BM_fillTriangleDepth)
+	->args({ 32, General })
+	->args({ 128, General })
+	->args({ 512, General });
+
+/**
+ * \brief drawLineP. Args: length (px), direction (0 horizontal, 
+ * 1 vertical, 2 diagonal, 3 shallow).
+ */
+static void BM_drawLineP(MicroState& state)
+{
+	static const char* directions[] = { "horizontal", "vertical", "diagonal", "shallow" };
+	const int length = state.arg(0);
+	const int direction = state.arg(1);
+
+	OffscreenGraphics& gfx = microGraphics();
+	Vec2 end = { 0, 0 };
+	switch (direction)
+	{
+	case 0: end = { length, 0 }; break;
+	case 1: end = { 0, length }; break;
+	case 2: end = { length, length }; break;
+	default: end = { length, length / 4 }; break;
+	}
+
+	while (state.keepRunning())
+	{
+		// drawLineP walks v1 towards v2
+		Vec2 v1 = { 10, 10 };
+		Vec2 v2 = { 10 + end.x, 10 + end.y };
+		gfx.drawLineP(v1, v2, 0x00ff00);
+	}
+
+	state.itemsProcessed = state.getIterations() * (int64_t)length;
+	state.label = "length:" + std::to_string(length) + "/" + directions[direction & 3];
+}
+MICRO_BENCHMARK(BM_drawLineP)
+	->args({ 16, 0 })
+	->args({ 256, 0 })
+	->args({ 256, 1 })
+	->args({ 256, 2 })
+	->args({ 256, 3 });
+
+/**
+ * \brief Texture::lookUp. Args: texture size, type (0 RGB, 1 RGBA), 
+ * access (0 along rows, 1 down columns, 2 random).
+ */
+static void BM_TextureLookUp(MicroState& state)
+{
+	static const char* accesses[] = { "rows", "columns", "random" };
+	const int size = state.arg(0);
+	const TextureType type = state.arg(1) == 0 ? TextureType::RGB : TextureType::RGBA;
+	const int access = state.arg(2);
+
+	Texture texture(type, size, size, size, size);
+
+	const int samples = 64;
+	std::vector<Vec2f> coords;
+	coords.reserve(samples * samples);
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> dist(0.0f, 0.999f);
+	for (int a = 0; a < samples; a++)
+	{
+		for (int b = 0; b < samples; b++)
+		{
+			const float fa = a / (float)samples;
+			const float fb = b / (float)samples;
+			switch (access)
+			{
+			case 0: coords.push_back(Vec2f(fb, fa)); break;
+			case 1: coords.push_back(Vec2f(fa, fb)); break;
+			default: coords.push_back(Vec2f(dist(rng), dist(rng))); break;
+			}
+		}
+	}
+
+	colour_t sum = 0;
+	while (state.keepRunning())
+	{
+		for (auto& c : coords)
+		{
+			sum += texture.lookUp(c.x, c.y);
+		}
+	}
+	doNotOptimise(sum);
+
+	state.itemsProcessed = state.getIterations() * (int64_t)coords.size();
+	state.label = "tex:" + std::to_string(size) + (type == TextureType::RGB ? "/rgb/" : "/rgba/") + 
+		accesses[access % 3];
+}
+MICRO_BENCHMARK(BM_TextureLookUp)
+	->args({ 16, 0, 0 })
+	->args({ 256, 0, 0 })
+	->args({ 256, 0, 1 })
+	->args({ 256, 0, 2 })
+	->args({ 1024, 0, 2 })
+	->args({ 256, 1, 0 })
+	->args({ 256, 1, 2 });
+
+/**
+ * \brief TriangleClipAgainstPlane. Args: number of corners inside the
+ * plane (0 - 3).
+ */
+static void BM_TriangleClipAgainstPlane(MicroState& state)
+{
+	const int inside = state.arg(0);
+
+	// Near plane as used by rasterTexturedTriangles
+	const Vec4f planeP = { 0.0f, 0.0f, 0.1f };
+	const Vec4f planeN = { 0.0f, 0.0f, 1.0f };
+
+	Triangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		triangle.p[i] = Vec4f((float)i, (float)(i * i), i < inside ? 5.0f : -5.0f);
+		triangle.t[i] = Vec3f((float)(i & 1), (float)(i >> 1), 1.0f);
+	}
+
+	Triangle clipped[2];
+	int total = 0;
+	while (state.keepRunning())
+	{
+		total += TriangleClipAgainstPlane(planeP, planeN, triangle, clipped[0], clipped[1]);
+	}
+	doNotOptimise(total);
+	doNotOptimise(clipped[0].p[2]);
+
+	state.itemsProcessed = state.getIterations();
+	state.label = "inside:" + std::to_string(inside);
+}
+MICRO_BENCHMARK(BM_TriangleClipAgainstPlane)
+	->args({ 0 })
+	->args({ 1 })
+	->args({ 2 })
+	->args({ 3 });
+
+/**
+ * \brief clearScreen. Args: width, height.
+ */
+static void BM_clearScreen(MicroState& state)
+{
+	OffscreenGraphics gfx(state.arg(0), state.arg(1));
+	while (state.keepRunning())
+	{
+		gfx.clearScreen(0xcdcdcd);
+	}
+	doNotOptimise(gfx.getPixels()[0]);
+	state.itemsProcessed = state.getIterations() * (int64_t)state.arg(0) * state.arg(1);
+}
+MICRO_BENCHMARK(BM_clearScreen)
+	->args({ 640, 480 })
+	->args({ 1280, 720 })
+	->args({ 1920, 1080 })
+	->args({ 3840, 2160 });
+
+/**
+ * \brief clearDepthBuffer. Args: width, height, RasterOptions::fastClear.
+ */
+static void BM_clearDepthBuffer(MicroState& state)
+{
+	OffscreenGraphics gfx(state.arg(0), state.arg(1));
+	gfx.rasterOptions.fastClear = state.arg(2) != 0;
+	while (state.keepRunning())
+	{
+		gfx.clearDepthBuffer();
+	}
+	doNotOptimise(gfx.getDepth()[0]);
+	state.itemsProcessed = state.getIterations() * (int64_t)state.arg(0) * state.arg(1);
+}
+MICRO_BENCHMARK(BM_clearDepthBuffer)
+	->args({ 640, 480, 0 })
+	->args({ 1280, 720, 0 })
+	->args({ 1920, 1080, 0 })
+	->args({ 3840, 2160, 0 })
+	->args({ 3840, 2160, 1 });
+
+/**
+ * \brief Matrix4x4 * Vec4f, as done for every vertex.
+ */
+static void BM_MatrixMultiplyVector(MicroState& state)
+{
+	Matrix4x4 m;
+	m.MakeRotationY(0.3f);
+	Vec4f v = { 1.0f, 2.0f, 3.0f };
+
+	while (state.keepRunning())
+	{
+		v = m * v;  // dependent chain, rotation keeps values bounded
+	}
+	doNotOptimise(v);
+	state.itemsProcessed = state.getIterations();
+}
+MICRO_BENCHMARK(BM_MatrixMultiplyVector);
+
+/**
+ * \brief Matrix4x4 * Matrix4x4, as done for every object.
+ */
+static void BM_MatrixMultiplyMatrix(MicroState& state)
+{
+	Matrix4x4 a, b;
+	a.MakeRotationX(0.2f);
+	b.MakeRotationZ(0.1f);
+
+	while (state.keepRunning())
+	{
+		a = a * b;
+	}
+	doNotOptimise(a);
+	state.itemsProcessed = state.getIterations();
+}
+MICRO_BENCHMARK(BM_MatrixMultiplyMatrix);
+
+/**
+ * \brief rasterTexturedTriangles of distant cubes sharing one mesh, so
+ * the time is spent transforming and clipping rather than filling pixels.
+ * Items are triangles submitted, the label counts vertices transformed per
+ * triangle. Args: cubes.
+ */
+static void BM_transformMeshes(MicroState& state)
+{
+	const int count = state.arg(0);
+
+	OffscreenGraphics& gfx = microGraphics();
+	const bool frontToBack = gfx.rasterOptions.frontToBack;
+	gfx.rasterOptions.frontToBack = false;
+
+	std::unique_ptr<Texture> texture(makeCheckerTexture(16));
+	Mesh mesh;
+	mesh.LoadTestCube("Cube");
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> across(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> ahead(200.0f, 400.0f);
+	std::vector<MeshInstance> vInstances(count);
+	std::vector<MeshInstance*> vPointers;
+	for (auto& instance : vInstances)
+	{
+		instance.pMesh = &mesh;
+		instance.pTexture = texture.get();
+		instance.matrixWorldPos.MakeTranslation(across(rng), across(rng), ahead(rng));
+		vPointers.push_back(&instance);
+	}
+
+	Matrix4x4 projectionMatrix, matrixCamera;
+	projectionMatrix.MakeProjection(90.0f, (float)MICRO_SCREEN_HEIGHT / (float)MICRO_SCREEN_WIDTH, 0.1f, 1000.0f);
+	matrixCamera.MakeIdentity();
+	const Vec4f vCamera(0.0f, 0.0f, 0.0f);
+	const Vec4f vLookDir(0.0f, 0.0f, 1.0f);
+
+	gfx.resetRasterStats();
+	while (state.keepRunning())
+	{
+		gfx.clearDepthBuffer();
+		ObjectHit hit;
+		doNotOptimise(gfx.rasterTexturedTriangles(projectionMatrix, matrixCamera, vCamera, vLookDir,
+			hit, 0.0f, vPointers, nullptr));
+	}
+
+	const uint64_t submitted = gfx.rasterStats.trianglesSubmitted;
+	const float perTriangle = submitted != 0 ? (float)gfx.rasterStats.verticesTransformed / (float)submitted : 0.0f;
+	state.itemsProcessed = (int64_t)submitted;
+	gfx.resetRasterStats();
+	gfx.rasterOptions.frontToBack = frontToBack;
+
+	char label[48];
+	std::snprintf(label, sizeof(label), "cubes:%d/verts_per_tri:%.2f", count, perTriangle);
+	state.label = label;
+}
+MICRO_BENCHMARK(BM_transformMeshes)
+	->args({ 1024 })
+	->args({ 8192 });
+
+/**
+ * \brief RenderQueue::sort of objects at random positions, as done every
+ * frame. Args: objects.
+ */
+static void BM_renderQueueSort(MicroState& state)
+{
+	const int count = state.arg(0);
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position(-64.0f, 64.0f);
+	std::vector<MeshInstance> vObjects(count);
+	std::vector<MeshInstance*> vPointers;
+	for (auto& o : vObjects)
+	{
+		o.matrixWorldPos.MakeTranslation(position(rng), position(rng), position(rng));
+		vPointers.push_back(&o);
+	}
+
+	RenderQueue queue;
+	const Vec4f vCamera(1.0f, 2.0f, 3.0f);
+	while (state.keepRunning())
+	{
+		doNotOptimise(queue.sort(vPointers, vCamera).front());
+	}
+	state.itemsProcessed = state.getIterations() * count;
+}
+MICRO_BENCHMARK(BM_renderQueueSort)
+	->args({ 4096 })
+	->args({ 65536 });
+
+/**
+ * \brief RenderCommandBuffer recording and sorting a mesh per object plus
+ * a HUD layer, as glRecordScene does each frame. Args: meshes.
+ */
+static void BM_renderCommandsRecordSort(MicroState& state)
+{
+	const int count = state.arg(0);
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position(-64.0f, 64.0f);
+	std::unique_ptr<Texture> textures[2] = { std::unique_ptr<Texture>(makeCheckerTexture(16)),
+		std::unique_ptr<Texture>(makeCheckerTexture(16)) };
+	std::vector<MeshInstance> vObjects(count);
+	for (size_t i = 0; i < vObjects.size(); i++)
+	{
+		vObjects[i].matrixWorldPos.MakeTranslation(position(rng), position(rng), position(rng));
+		vObjects[i].pTexture = textures[i % 2].get();
+	}
+
+	Matrix4x4 projectionMatrix, matrixCamera;
+	const Vec4f vCamera(1.0f, 2.0f, 3.0f);
+	const Vec4f vLookDir(0.0f, 0.0f, 1.0f);
+	const std::string text = "Inventory slot: 1/10";
+
+	RenderCommandBuffer commands;
+	while (state.keepRunning())
+	{
+		commands.reset();
+		commands.setLayer(RenderLayer::HUD);
+		commands.drawText(text, { 0, 20 }, 0x000000);
+		commands.setLayer(RenderLayer::Scene);
+		commands.clear(0xcdcdcd);
+		commands.clearDepth();
+		commands.setView(projectionMatrix, matrixCamera, vCamera, vLookDir, 5.0f);
+		for (auto& o : vObjects)
+		{
+			commands.drawMesh(&o);
+		}
+		commands.sort();
+		doNotOptimise(commands.size());
+	}
+	state.itemsProcessed = state.getIterations() * count;
+}
+MICRO_BENCHMARK(BM_renderCommandsRecordSort)
+	->args({ 4096 })
+	->args({ 65536 });
+
+/**
+ * \brief Graphics::blit of a full screen overlay, like the HUD sprite.
+ * Args: content (0 transparent, 1 opaque, 2 HUD-like mix), mode 
+ * (0 copy, 1 blend).
+ */
+static void BM_blitOverlay(MicroState& state)
+{
+	static const char* contents[] = { "transparent", "opaque", "hud" };
+	const int content = state.arg(0);
+	const BlitMode mode = state.arg(1) == 0 ? BlitMode::Copy : BlitMode::Blend;
+
+	OffscreenGraphics& gfx = microGraphics();
+	const int w = gfx.getWidth();
+	const int h = gfx.getHeight();
+
+	// HUD-like: mostly transparent with opaque bars and soft edges
+	std::vector<colour_t> overlay(w * h);
+	for (int y = 0; y < h; y++)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			colour_t alpha = 0;
+			switch (content)
+			{
+			case 0: alpha = 0; break;
+			case 1: alpha = 0xff; break;
+			default:
+				if (y < 40 || y > h - 40)
+					alpha = 0xff;
+				else if (y < 48 || y > h - 48)
+					alpha = 0x80;
+				break;
+			}
+			overlay[x + y * w] = (alpha << 24) | 0x2053da;
+		}
+	}
+	premultiplyAlpha(overlay.data(), overlay.size());
+
+	while (state.keepRunning())
+	{
+		gfx.blit(overlay.data(), w, h, { 0, 0 }, mode);
+	}
+
+	state.itemsProcessed = state.getIterations() * (int64_t)w * h;
+	state.label = std::string(contents[content % 3]) + (mode == BlitMode::Copy ? "/copy" : "/blend");
+}
+MICRO_BENCHMARK(BM_blitOverlay)
+	->args({ 2, 0 })
+	->args({ 0, 1 })
+	->args({ 1, 1 })
+	->args({ 2, 1 });
+
+/**
+ * \brief UICompositor frame of a menu: full screen background and three 
+ * buttons. Args: mode (0 overlay, 1 exclusive), change (0 idle, 1 one 
+ * button changes colour every frame).
+ */
+static void BM_compositeMenu(MicroState& state)
+{
+	const CompositeMode mode = state.arg(0) == 0 ? CompositeMode::Overlay : CompositeMode::Exclusive;
+	const bool change = state.arg(1) != 0;
+
+	OffscreenGraphics& gfx = microGraphics();
+	UICompositor compositor(gfx);
+
+	int64_t frame = 0;
+	while (state.keepRunning())
+	{
+		compositor.begin();
+		compositor.drawRect({ 0.0f, 0.0f }, { 1.0f, 1.0f }, 0x2053da);
+		compositor.drawRect({ 0.43f, 0.56f }, { 0.57f, 0.64f }, change && (frame & 1) ? 0xffffff : 0x808080);
+		compositor.drawRect({ 0.43f, 0.46f }, { 0.57f, 0.54f }, 0x808080);
+		compositor.drawRect({ 0.43f, 0.36f }, { 0.57f, 0.44f }, 0x808080);
+		compositor.composite(mode);
+		frame++;
+	}
+
+	state.itemsProcessed = state.getIterations();
+	state.label = std::string(mode == CompositeMode::Overlay ? "overlay" : "exclusive") + (change ? "/change" : "/idle");
+}
+MICRO_BENCHMARK(BM_compositeMenu)
+	->args({ 0, 0 })
+	->args({ 1, 0 })
+	->args({ 1, 1 });
+
+/**
+ * \brief Returns the text of an .obj grid of size x size quads with
+ * texture coords and a normal, as written by modelling tools.
+ */
+static std::string makeObjGrid(const int size)
+{
+	std::string text;
+	char line[192];  // eight ints of a face at most 11 characters each
+	for (int z = 0; z <= size; z++)
+	{
+		for (int x = 0; x <= size; x++)
+		{
+			std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n",
+				(float)x / size, 0.01f * (float)((x * 7 + z * 13) % 17), (float)z / size, (float)x / size, (float)z / size);
+			text += line;
+		}
+	}
+	text += "vn 0.000000 1.000000 0.000000\n";
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			const int i = z * (size + 1) + x + 1;
+			const int j = i + size + 1;
+			std::snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", i, i, i + 1, i + 1, j + 1, j + 1, j, j);
+			text += line;
+		}
+	}
+	return text;
+}
+
+/**
+ * \brief ObjLoader::parse of a grid of quads from memory. Items are
+ * triangles. Args: quads per side, threads (0 for every hardware thread).
+ */
+static void BM_parseObj(MicroState& state)
+{
+	const int size = state.arg(0);
+	const std::string text = makeObjGrid(size);
+
+	ObjLoader loader;
+	loader.threadCount = (uint)state.arg(1);
+	while (state.keepRunning())
+	{
+		loader.parse(text.data(), text.size(), "grid");
+		doNotOptimise(loader.vCorners.data());
+	}
+
+	state.itemsProcessed = state.getIterations() * (int64_t)loader.getTriangleCount();
+	state.label = "quads:" + std::to_string(size) + "^2/threads:" + std::to_string(state.arg(1)) +
+		"/MiB:" + std::to_string(text.size() >> 20);
+}
+MICRO_BENCHMARK(BM_parseObj)
+	->args({ 256, 1 })
+	->args({ 1024, 1 })
+	->args({ 1024, 0 });
@@ -0,0 +1,123 @@
+#include "frame_pipeline.h"
+#include "profiler.h"
+
+FramePipeline::~FramePipeline()
+{
+	stop();
+}
+
+/**
+ * \brief Starts the render thread.
+ *
+ * \param renderFunc Called on the render thread with each submitted slot
+ */
+void FramePipeline::start(std::function<void(const int)> renderFunc)
+{
+	if (isRunning())
+	{
+		return;
+	}
+
+	render = std::move(renderFunc);
+	stopping = false;
+	thread = std::thread(&FramePipeline::threadMain, this);
+}
+
+/**
+ * \brief Renders every submitted slot, then joins the render thread.
+ */
+void FramePipeline::stop()
+{
+	if (!isRunning())
+	{
+		return;
+	}
+
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stopping = true;
+	}
+	cv.notify_all();
+	thread.join();
+}
+
+/**
+ * \brief Returns the next slot to record a frame into, waiting until the
+ * frame previously submitted in it has been rendered.
+ */
+const int FramePipeline::acquire()
+{
+	PROFILE_SCOPE("Wait for render");
+
+	const int slot = nextSlot;
+	nextSlot = (nextSlot + 1) % FRAME_PIPELINE_SLOTS;
+
+	std::unique_lock<std::mutex> lock(mtx);
+	cv.wait(lock, [&] { return !busy[slot]; });
+	return slot;
+}
+
+/**
+ * \brief Queues a slot returned by acquire() to be rendered.
+ *
+ * If the render thread is not running the slot is rendered on the calling
+ * thread.
+ */
+void FramePipeline::submit(const int slot)
+{
+	if (!isRunning())
+	{
+		render(slot);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		busy[slot] = true;
+		dSubmitted.push_back(slot);
+	}
+	cv.notify_all();
+}
+
+/**
+ * \brief Waits until every submitted slot has been rendered.
+ */
+void FramePipeline::wait()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	cv.wait(lock, [&]
+		{
+			for (int i = 0; i < FRAME_PIPELINE_SLOTS; i++)
+			{
+				if (busy[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		});
+}
+
+void FramePipeline::threadMain()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	for (;;)
+	{
+		cv.wait(lock, [&] { return stopping || !dSubmitted.empty(); });
+		if (dSubmitted.empty())
+		{
+			return;  // stopping
+		}
+
+		const int slot = dSubmitted.front();
+		dSubmitted.pop_front();
+
+		lock.unlock();
+		render(slot);
+		lock.lock();
+
+		busy[slot] = false;
+		cv.notify_all();
+	}
+}
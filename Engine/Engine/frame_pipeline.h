@@ -0,0 +1,59 @@
+/*****************************************************************//**
+ * \file   frame_pipeline.h
+ * \brief  Contains FramePipeline class to render frames on their own
+ * thread while the next frame is simulated
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#define FRAME_PIPELINE_SLOTS (2)	///< Frames recorded or rendered at once
+
+/**
+ * \brief Hands recorded frames from the game thread to a render thread.
+ *
+ * The caller keeps FRAME_PIPELINE_SLOTS copies of whatever a frame needs
+ * (camera, visible objects, UI). Each frame, acquire() returns a slot that
+ * is no longer being rendered, the game thread fills it and submit() queues
+ * it for the render function. While a slot is rendered the game thread
+ * records the next frame into the other one, so a frame takes as long as
+ * the slower of the two threads rather than both of them.
+ *
+ * \note A slot must not be touched between submit() and the acquire() that
+ * returns it again. Call wait() before drawing on any other thread.
+ */
+class FramePipeline
+{
+private:
+	std::thread thread;									///< Runs render
+	std::mutex mtx;										///< Guards the members below
+	std::condition_variable cv;							///< Signals submitted and rendered slots
+	std::function<void(const int)> render;				///< Draws and presents a slot
+	std::deque<int> dSubmitted;							///< Slots waiting to be rendered
+	bool busy[FRAME_PIPELINE_SLOTS] = {};				///< Slot is submitted or rendering
+	bool stopping = false;								///< Render thread should exit
+	int nextSlot = 0;									///< Slot returned by the next acquire
+
+	void threadMain();
+
+public:
+	FramePipeline() = default;
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+	~FramePipeline();
+
+	void start(std::function<void(const int)> renderFunc);
+	void stop();
+	const bool isRunning() const { return thread.joinable(); }
+
+	const int acquire();
+	void submit(const int slot);
+	void wait();
+};
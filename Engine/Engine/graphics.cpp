@@ -2,6 +2,7 @@
 #include "utils.h"
 #include "graphics.h"
 #include "graphics_objects.h"
+#include "profiler.h"
 #include <algorithm>
 #include <list>
 #include <assert.h>
@@ -30,6 +31,29 @@ intersectTriangle(
 
 
 
+/**
+ * \brief Projects a point in camera space to pixels.
+ *
+ * \param screen Set to the point in pixels, z is depth
+ * \return Clip space w of the point, which perspective correct texture 
+ * coordinates are divided by
+ */
+const float Graphics::projectToScreen(const Matrix4x4& projectionMatrix, const Vec4f& p, Vec4f& screen) const
+{
+	screen = projectionMatrix * p;
+	const float w = screen.w;
+	screen /= w;
+
+	// Invert
+	screen.x *= -1;
+
+	Vec4f vOffsetView = { 1, 1, 0 };
+	screen += vOffsetView;
+	screen.x *= 0.5f * (float)width;
+	screen.y *= 0.5f * (float)height;
+	return w;
+}
+
 Graphics::~Graphics()
 {
 	delete text2D;
@@ -49,6 +73,25 @@ void Graphics::destroySprites()
 	sprites.clear();
 }
 
+/**
+ * \brief Invalidates everything that was scaled to the previous size.
+ * Called by implementations after the buffers change size.
+ * 
+ * Sprites are rescaled immediately, GUISprite caches are rebuilt the next
+ * time they are drawn (see getSizeGeneration).
+ */
+void Graphics::onSizeChanged()
+{
+	sizeGeneration++;
+	vTileDepth.clear();
+	rasterTiled = false;
+	vTileFlags.clear();
+	for (auto s : sprites)
+	{
+		s->updateSize();
+	}
+}
+
 void Graphics::drawSprites()
 {
 	for (auto s : sprites)
@@ -142,6 +185,11 @@ void Graphics::drawLineP(Vec2& v1, Vec2& v2, colour_t colour)
 }
 
 
+/**
+ * \brief Draws frames per second in the top-left of pBuffer.
+ * 
+ * Only formats and lays out the text again when fFPS changes.
+ */
 void Graphics::drawFPS(const float fFPS, const colour_t colour)
 {
 	Vec2 v;
@@ -149,79 +197,160 @@ void Graphics::drawFPS(const float fFPS, const colour_t colour)
 
 	v.x = 0; v.y = height - textHeight;
 
-	std::stringstream streamFPS;
-	streamFPS << std::fixed << std::setprecision(2) 
-		<< "FPS: " << fFPS;
+	if (layoutFPS.updateKey(fFPS))
+	{
+		layoutFPS.format("FPS: %.2f", fFPS);
+	}
 
-	drawText(streamFPS.str(), v, colour);
+	drawTextLayout(layoutFPS, v, colour);
 }
 
+/**
+ * \brief Draws camera position, velocity and orientation below the FPS.
+ * 
+ * Each line is only formatted and laid out again when its values change.
+ */
 void Graphics::drawPos(const Vec4f vCamera, const Vec4f vVelocity, const uint accelerationFlags, const float fYaw, const float fPitch, const colour_t colour)
 {
 	const int textHeight = 20;  // TODO
 	Vec2 v = { 0, height - textHeight };
 
-	std::stringstream streamPos, streamVel, streamYaw, streamPitch;
-	streamPos << std::fixed << std::setprecision(2) 
-		<< "Pos:"
-		<< " x: " << vCamera.x
-		<< " y: " << vCamera.y
-		<< " z: " << vCamera.z;
-	streamVel << std::fixed << std::setprecision(2) 
-		<< "Vel:"
-		<< " x: " << vVelocity.x
-		<< " y: " << vVelocity.y
-		<< " z: " << vVelocity.z;
-	streamYaw << std::fixed << std::setprecision(2) 
-		<< "Yaw: " << fYaw;
-	streamPitch << std::fixed << std::setprecision(2) 
-		<< "Pitch: " << fPitch;
-
-	v.y = v.y - textHeight;
-	drawText(streamPos.str(), v, colour);
-	v.y = v.y - textHeight;
-	drawText(streamVel.str(), v, colour);
-	v.y = v.y - textHeight;
-	drawText(std::to_string(accelerationFlags), v, colour);
-	v.y = v.y - textHeight;
-	drawText(streamYaw.str(), v, colour);
-	v.y = v.y - textHeight;
-	drawText(streamPitch.str(), v, colour);
+	if (layoutPos[0].updateKey(vCamera))
+	{
+		layoutPos[0].format("Pos: x: %.2f y: %.2f z: %.2f", vCamera.x, vCamera.y, vCamera.z);
+	}
+	if (layoutPos[1].updateKey(vVelocity))
+	{
+		layoutPos[1].format("Vel: x: %.2f y: %.2f z: %.2f", vVelocity.x, vVelocity.y, vVelocity.z);
+	}
+	if (layoutPos[2].updateKey(accelerationFlags))
+	{
+		layoutPos[2].format("%u", accelerationFlags);
+	}
+	if (layoutPos[3].updateKey(fYaw))
+	{
+		layoutPos[3].format("Yaw: %.2f", fYaw);
+	}
+	if (layoutPos[4].updateKey(fPitch))
+	{
+		layoutPos[4].format("Pitch: %.2f", fPitch);
+	}
+
+	for (auto& layout : layoutPos)
+	{
+		v.y = v.y - textHeight;
+		drawTextLayout(layout, v, colour);
+	}
 }
 
+/**
+ * \brief Draws the per-frame profiler summary in the top-right of pBuffer.
+ * 
+ * Each scope is indented by its nesting depth so the frame hierarchy 
+ * (input, simulate, cull, transform, clip, raster, present) can be read
+ * directly from the overlay.
+ * 
+ * \param profiler Profiler containing summary of the last completed frame
+ * \param colour Colour of text
+ */
+void Graphics::drawProfiler(const Profiler& profiler, const colour_t colour)
+{
+	drawProfiler(profiler.getFrameMs(), profiler.getSummary(), colour);
+}
+
+/**
+ * \brief Draws a profiler summary copied from another thread.
+ * 
+ * \param fFrameMs Duration of the summarised frame
+ * \param vSummary Scopes of the summarised frame
+ * \param colour Colour of text
+ */
+void Graphics::drawProfiler(const float fFrameMs, const std::vector<ProfileSummary>& vSummary, const colour_t colour)
+{
+	const int textHeight = TEXT2D_GLYPH_ROWS + 1;  // a blank row between lines, as drawPos
+	const int numColumns = 28;
+	Vec2 v = { width - (numColumns * TEXT2D_GLYPH_WIDTH), height - textHeight };
+
+	std::stringstream streamFrame;
+	streamFrame << std::fixed << std::setprecision(2)
+		<< "Frame: " << fFrameMs << "ms";
+	drawText(streamFrame.str(), v, colour);
+
+	for (auto& s : vSummary)
+	{
+		v.y = v.y - textHeight;
+		if (v.y < 0)
+		{
+			return;
+		}
+
+		std::stringstream streamScope;
+		streamScope << std::fixed << std::setprecision(2)
+			<< std::string(s.depth, ' ') << s.name << ": " << s.fMs << "ms";
+		if (s.calls > 1)
+		{
+			streamScope << " x" << s.calls;
+		}
+		drawText(streamScope.str(), v, colour);
+	}
+}
+
+/**
+ * \brief Copies a buffer of pixels covering vf1 to vf2 into pBuffer.
+ * 
+ * \param buffer Pixels (colour_t) of the area in screen pixels
+ * \param vf1 Bottom-left coords
+ * \param vf2 Top-right coords
+ */
 void Graphics::drawColourBuffer(void* buffer, Vec2f vf1, Vec2f vf2)
 {
 	Vec2 v1 = screenToPx(vf1);
 	Vec2 v2 = screenToPx(vf2);
-	clamp(&v1.x, 0, width);
-	clamp(&v2.x, 0, width);
-	clamp(&v1.y, 0, height);
-	clamp(&v2.y, 0, height);
-	const uint bufferWidth = v2.x - v1.x;
+	blit((const colour_t*)buffer, v2.x - v1.x, v2.y - v1.y, v1, BlitMode::Copy);
+}
 
-	colour_t* pixel = (colour_t*)pBuffer;
-	for (int y = v1.y; y < v2.y; y++)
+/**
+ * \brief Copies or blends a buffer of pixels into pBuffer.
+ * 
+ * The rectangle is clipped against pBuffer once, after which whole rows 
+ * are handed to the blit kernels.
+ * 
+ * \param src Source pixels, premultiplied alpha for BlitMode::Blend
+ * \param srcWidth Width of src in pixels (also its row stride)
+ * \param srcHeight Height of src in pixels
+ * \param v Bottom-left pixel of pBuffer to draw src at
+ * \param mode How source pixels are combined with pBuffer
+ * 
+ * \see blitRect
+ */
+void Graphics::blit(const colour_t* src, const int srcWidth, const int srcHeight, const Vec2 v, const BlitMode mode)
+{
+	if (src == nullptr)
 	{
-		for (int x = v1.x; x < v2.x; x++)
-		{
-			pixel[x + (y * width)] = reinterpret_cast<colour_t*>(buffer)[(x - v1.x) + ((y - v1.y) * bufferWidth)];
-		}
+		return;
 	}
+
+	int x1 = v.x, y1 = v.y;
+	int x2 = v.x + srcWidth, y2 = v.y + srcHeight;
+	clamp(&x1, 0, width);
+	clamp(&x2, 0, width);
+	clamp(&y1, 0, height);
+	clamp(&y2, 0, height);
+
+	colour_t* dst = (colour_t*)pBuffer + x1 + y1 * width;
+	src += (x1 - v.x) + (y1 - v.y) * srcWidth;
+	blitRect(dst, width, src, srcWidth, x2 - x1, y2 - y1, mode);
 }
 
 
 /**
- * \brief Iterates through pBuffer and sets pixels to a common colour.
+ * \brief Sets every pixel of pBuffer to a common colour (see fillStream).
  * 
  * \param colour Colour to be drawn
  */
 void Graphics::clearScreen(colour_t colour)
 {
-	colour_t* pixel = (colour_t*)pBuffer;
-	for (int i = 0; i < width * height; i++)
-	{
-		*pixel++ = colour;
-	}
+	fillStream((uint*)pBuffer, colour, (size_t)width * height);
 }
 
 /**
@@ -297,104 +426,125 @@ void Graphics::drawTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, const colour_t colour
 }
 
 /**
- * \brief Draws solid colour triangle.
+ * \brief Walks the edge a -> b (a.y < b.y) one row at a time with integer
+ * arithmetic only.
  * 
- * If the given triangle is a flat-top or bottom-top triangle it will draw
- * the corresponding one. If it is niether it must be broken up into these
- * different flat-top and flat-bottom triangles and then draw.
- *
- * \see fillTopFlatTriangleP
- * \see fillBottomFlatTriangleP
+ * Pixel centres are at +0.5. On each row, x is the first pixel whose 
+ * centre is on or right of the edge, so a span [left.x, right.x) covers 
+ * centres that lie exactly on its left edge but not on its right edge 
+ * (top-left rule). As vertices are whole pixels, no centre can lie on a 
+ * horizontal edge.
  */
-void Graphics::fillTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour)
+struct EdgeStepper
 {
-	// Sort ascending by Y
-	if (v1.y > v2.y)
-	{
-		std::swap(v1.x, v2.x);
-		std::swap(v1.y, v2.y);
-	}
-	if (v2.y > v3.y)
+	int x;			///< First pixel on or right of the edge on current row
+	int err;		///< Remainder of x in units of 1/denom, [0, denom)
+	int stepX;		///< Whole pixels x moves per row
+	int stepErr;	///< Remainder x moves per row
+	int denom;		///< 2 * height of edge
+
+	EdgeStepper(const Vec2& a, const Vec2& b, const int y)
 	{
-		std::swap(v2.x, v3.x);
-		std::swap(v2.y, v3.y);
+		const int dx = b.x - a.x;
+		const int dy = b.y - a.y;
+		denom = 2 * dy;
 
-		if (v1.y > v2.y)
-		{
-			std::swap(v1.x, v2.x);
-			std::swap(v1.y, v2.y);
-		}
-	}
+		// x = ceil(edge x at row centre - 0.5)
+		const int64_t num = (int64_t)2 * a.x * dy + (int64_t)(2 * (y - a.y) + 1) * dx - dy + denom - 1;
+		x = (int)floorDiv(num, denom);
+		err = (int)(num - (int64_t)x * denom);
 
-	std::swap(v1.x, v3.x);
-	std::swap(v1.y, v3.y);
-	
-	if (v2.y == v3.y)
-	{
-		fillBottomFlatTriangleP(v1, v2, v3, colour);
-	}
-	else if (v1.y == v2.y)
-	{
-		fillTopFlatTriangleP(v1, v2, v3, colour);
+		stepX = (int)floorDiv(2 * dx, denom);
+		stepErr = 2 * dx - stepX * denom;
 	}
-	else
+
+	inline void step()
 	{
-		// Split triangle into flat top and flat bottom
-		Vec2 v4;
-		v4.x = (int)(v1.x + ((float)(v2.y - v1.y) / (float)(v3.y - v1.y)) * (v3.x - v1.x));
-		v4.y = v2.y;
-		fillBottomFlatTriangleP(v1, v2, v4, colour);
-		fillTopFlatTriangleP(v2, v4, v3, colour);
+		x += stepX;
+		err += stepErr;
+		if (err >= denom)
+		{
+			x++;
+			err -= denom;
+		}
 	}
-}
+};
 
 /**
- * \brief Draws triangle with a flat-top.
+ * \brief Draws solid colour triangle.
  * 
- * \see Called by fillTriangleP
+ * \see fillTriangleSpans
  */
-void Graphics::fillTopFlatTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour)
+void Graphics::fillTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour)
 {
-	assert(v3.y - v1.y != 0);
-	assert(v3.y - v2.y != 0);
-	float invslope1 = (float)(v3.x - v1.x) / (float)(v3.y - v1.y);
-	float invslope2 = (float)(v3.x - v2.x) / (float)(v3.y - v2.y);
-
-	float curx1 = (float)v3.x;
-	float curx2 = (float)v3.x;
-
-	for (int scanlineY = v3.y; scanlineY <= v1.y; scanlineY++)
-	{
-		Vec2 v1_ = { (int)curx1, scanlineY };
-		Vec2 v2_ = { (int)curx2, scanlineY };
-		drawLineP(v1_, v2_, colour);
-		curx1 += invslope1;
-		curx2 += invslope2;
-	}
+	const Vec2 v[3] = { v1, v2, v3 };
+	fillTriangleSpans(v, colour);
 }
 
 /**
- * \brief Draws triangle with a flat-bottom.
- *
- * \see Called by fillTriangleP
+ * \brief Rasterises a solid triangle as horizontal spans.
+ * 
+ * Edges are walked with EdgeStepper and each span is clipped to the buffer
+ * once, then filled with fillRow. No depth testing.
+ * 
+ * \param v Corners in pixel coords
+ * \param colour Colour of triangle
  */
-void Graphics::fillBottomFlatTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour)
+void Graphics::fillTriangleSpans(const Vec2 v[3], const colour_t colour)
 {
-	assert(v2.y - v1.y != 0);
-	assert(v3.y - v1.y != 0);
-	float invslope1 = (float)(v2.x - v1.x) / (float)(v2.y - v1.y);
-	float invslope2 = (float)(v3.x - v1.x) / (float)(v3.y - v1.y);
+	// Sort ascending by Y
+	int i0 = 0, i1 = 1, i2 = 2;
+	if (v[i0].y > v[i1].y) std::swap(i0, i1);
+	if (v[i1].y > v[i2].y) std::swap(i1, i2);
+	if (v[i0].y > v[i1].y) std::swap(i0, i1);
+	const Vec2& a = v[i0];
+	const Vec2& b = v[i1];
+	const Vec2& c = v[i2];
+
+	// Twice the signed area, > 0 when b is left of the long edge a -> c
+	const int64_t area = (int64_t)(c.x - a.x) * (b.y - a.y) - (int64_t)(c.y - a.y) * (b.x - a.x);
+	if (area == 0)
+	{
+		return;
+	}
+	const bool longEdgeRight = area > 0;
 
-	float curx1 = (float)v1.x;
-	float curx2 = (float)v1.x;
+	const int yStart = a.y < 0 ? 0 : a.y;
+	const int yEnd = c.y > height ? height : c.y;
+	if (yStart >= yEnd)
+	{
+		return;
+	}
+
+	colour_t* pixels = (colour_t*)pBuffer;
 
-	for (int scanlineY = v1.y; scanlineY >= v2.y; scanlineY--)
+	EdgeStepper longEdge(a, c, yStart);
+	for (int half = 0; half < 2; half++)
 	{
-		Vec2 v1_ = { (int)curx1, scanlineY };
-		Vec2 v2_ = { (int)curx2, scanlineY };
-		drawLineP(v1_, v2_, colour);
-		curx1 -= invslope1;
-		curx2 -= invslope2;
+		const Vec2& s0 = half == 0 ? a : b;
+		const Vec2& s1 = half == 0 ? b : c;
+		int y = s0.y > yStart ? s0.y : yStart;
+		const int yHalfEnd = s1.y < yEnd ? s1.y : yEnd;
+		if (y >= yHalfEnd)
+		{
+			continue;
+		}
+
+		EdgeStepper shortEdge(s0, s1, y);
+		EdgeStepper& left = longEdgeRight ? shortEdge : longEdge;
+		EdgeStepper& right = longEdgeRight ? longEdge : shortEdge;
+
+		for (; y < yHalfEnd; y++)
+		{
+			const int x1 = left.x < 0 ? 0 : left.x;
+			const int x2 = right.x > width ? width : right.x;
+			if (x1 < x2)
+			{
+				fillRow(pixels + y * width + x1, colour, x2 - x1);
+			}
+			left.step();
+			right.step();
+		}
 	}
 }
 
@@ -418,211 +568,126 @@ void Graphics::drawRect(const Vec2f& vf1, const Vec2f& vf2, colour_t colour)
 /**
  * \brief Clears the depth buffer (pDepthBuffer).
  * 
- * Sets all elements to 0.0f
+ * Sets all elements to 0.0f, and the depth bounds of every tile with it
+ * (see RasterOptions::depthBounds). With RasterOptions::tiledTargets, 
+ * vTiledDepth is cleared instead and 3D triangles are drawn to the tiled
+ * targets until the next call. With RasterOptions::fastClear, tiles are
+ * only marked to be cleared when first drawn to (see prepareTile).
  */
 void Graphics::clearDepthBuffer()
 {
-	float* depthBuffer = (float*)pDepthBuffer;
-	for (int i = 0; i < width * height; i++)
+	const size_t tiles = (size_t)depthTilesX() * depthTilesY();
+	const bool fastClear = rasterOptions.fastClear;
+	rasterTiled = rasterOptions.tiledTargets;
+	vOutlines.clear();
+
+	if (rasterTiled)
 	{
-		*depthBuffer++ = 0.0f;
+		vTiledColour.resize(tiles * RASTER_TILE_PIXELS);
+		vTiledDepth.resize(tiles * RASTER_TILE_PIXELS);
+		if (!fastClear)
+		{
+			fillStream((uint*)vTiledDepth.data(), 0, vTiledDepth.size());
+		}
+	}
+	else if (!fastClear)
+	{
+		// 0.0f is all bits zero
+		fillStream((uint*)pDepthBuffer, 0, (size_t)width * height);
 	}
-}
 
-/**
- * \brief Returns element of depth buffer (pDepthBuffer).
- */
-float* Graphics::readDepthBuffer(const uint x, const uint y)
-{
-	float* depthBuffer = (float*)pDepthBuffer;
-	return &depthBuffer[x * width + y];
+	if (rasterTiled || fastClear)
+	{
+		vTileFlags.assign(tiles, fastClear ? 0 : RASTER_TILE_DEPTH);
+	}
+	else
+	{
+		vTileFlags.clear();
+	}
+
+	if (rasterOptions.countOverdraw)
+	{
+		vOverdraw.assign((size_t)width * height, 0);
+	}
+	else
+	{
+		vOverdraw.clear();
+	}
+
+	if (rasterOptions.depthBounds)
+	{
+		vTileDepth.assign(tiles, 0.0f);
+	}
+	else
+	{
+		vTileDepth.clear();
+	}
 }
 
 /**
- * \brief Draws textured triangle to pBuffer.
- * 
- * Algorithm from: https://github.com/OneLoneCoder/videos/blob/master/OneLoneCoder_olcEngine3D_Part4.cpp
- * 
- * Once texture u/v coordinates are found the corresponding texture data is drawn to the pBuffer
- * 
- * \see texture->lookUp
+ * \brief Returns element of depth buffer (pDepthBuffer, or vTiledDepth 
+ * while drawing to tiled targets) at pixel (x, y).
  */
-void Graphics::drawTexturedTriangle(Triangle& triangle)
+float* Graphics::readDepthBuffer(const uint x, const uint y)
 {
-	int x1 = (int)triangle.p[0].x, y1 = (int)triangle.p[0].y; 
-	int x2 = (int)triangle.p[1].x, y2 = (int)triangle.p[1].y; 
-	int x3 = (int)triangle.p[2].x, y3 = (int)triangle.p[2].y;
-	float u1 = triangle.t[0].u, v1 = triangle.t[0].v, w1 = triangle.t[0].w;
-	float u2 = triangle.t[1].u, v2 = triangle.t[1].v, w2 = triangle.t[1].w;
-	float u3 = triangle.t[2].u, v3 = triangle.t[2].v, w3 = triangle.t[2].w;
-	const Texture* texture = triangle.parent->pTexture;
-
-	if (y2 < y1)
+	if (!vTileFlags.empty())
 	{
-		std::swap(y1, y2);
-		std::swap(x1, x2);
-		std::swap(u1, u2);
-		std::swap(v1, v2);
-		std::swap(w1, w2);
+		prepareTile(x / RASTER_BLOCK_SIZE, y / RASTER_BLOCK_SIZE, RASTER_TILE_DEPTH);
 	}
 
-	if (y3 < y1)
+	if (rasterTiled)
 	{
-		std::swap(y1, y3);
-		std::swap(x1, x3);
-		std::swap(u1, u3);
-		std::swap(v1, v3);
-		std::swap(w1, w3);
+		return &vTiledDepth[rasterTileOffset(x, y, depthTilesX())];
 	}
 
-	if (y3 < y2)
+	float* depthBuffer = (float*)pDepthBuffer;
+	return &depthBuffer[x + y * width];
+}
+
+/**
+ * \brief Copies tiles drawn to the tiled targets into pBuffer, then draws
+ * the outlines of their triangles over them (see 
+ * RasterOptions::tiledTargets).
+ *
+ * Only tiles which were drawn to are copied, the rest of pBuffer is left
+ * as it is. Called by rasterTexturedTriangles. Triangles drawn by 
+ * rasterTriangles directly must be resolved before drawing anything else 
+ * to pBuffer. Does nothing if the targets are not tiled.
+ */
+void Graphics::resolveRasterTargets()
+{
+	if (!rasterTiled)
 	{
-		std::swap(y2, y3);
-		std::swap(x2, x3);
-		std::swap(u2, u3);
-		std::swap(v2, v3);
-		std::swap(w2, w3);
+		return;
 	}
 
-	int dy1 = y2 - y1;
-	int dx1 = x2 - x1;
-	float dv1 = v2 - v1;
-	float du1 = u2 - u1;
-	float dw1 = w2 - w1;
-
-	int dy2 = y3 - y1;
-	int dx2 = x3 - x1;
-	float dv2 = v3 - v1;
-	float du2 = u3 - u1;
-	float dw2 = w3 - w1;
-
-	float tex_u, tex_v, tex_w;
-
-	float dax_step = 0, dbx_step = 0,
-		du1_step = 0, dv1_step = 0,
-		du2_step = 0, dv2_step = 0,
-		dw1_step = 0, dw2_step = 0;
-
-	if (dy1) dax_step = dx1 / (float)abs(dy1);
-	if (dy2) dbx_step = dx2 / (float)abs(dy2);
-
-	if (dy1) du1_step = du1 / (float)abs(dy1);
-	if (dy1) dv1_step = dv1 / (float)abs(dy1);
-	if (dy1) dw1_step = dw1 / (float)abs(dy1);
-
-	if (dy2) du2_step = du2 / (float)abs(dy2);
-	if (dy2) dv2_step = dv2 / (float)abs(dy2);
-	if (dy2) dw2_step = dw2 / (float)abs(dy2);
-
-	if (dy1)
+	const int tilesX = depthTilesX();
+	const int tilesY = depthTilesY();
+	colour_t* pixels = (colour_t*)pBuffer;
+	for (int ty = 0; ty < tilesY; ty++)
 	{
-		for (int i = y1; i <= y2; i++)
+		const int y = ty * RASTER_BLOCK_SIZE;
+		const int h = std::min(RASTER_BLOCK_SIZE, height - y);
+		for (int tx = 0; tx < tilesX; tx++)
 		{
-			int ax = x1 + (int)((float)(i - y1) * dax_step);
-			int bx = x1 + (int)((float)(i - y1) * dbx_step);
-
-			float tex_su = u1 + (float)(i - y1) * du1_step;
-			float tex_sv = v1 + (float)(i - y1) * dv1_step;
-			float tex_sw = w1 + (float)(i - y1) * dw1_step;
-
-			float tex_eu = u1 + (float)(i - y1) * du2_step;
-			float tex_ev = v1 + (float)(i - y1) * dv2_step;
-			float tex_ew = w1 + (float)(i - y1) * dw2_step;
-
-			if (ax > bx)
-			{
-				std::swap(ax, bx);
-				std::swap(tex_su, tex_eu);
-				std::swap(tex_sv, tex_ev);
-				std::swap(tex_sw, tex_ew);
-			}
-
-			tex_u = tex_su;
-			tex_v = tex_sv;
-			tex_w = tex_sw;
-
-			float tstep = 1.0f / ((float)(bx - ax));
-			float t = 0.0f;
-
-			for (int j = ax; j < bx; j++)
+			const size_t tile = (size_t)ty * tilesX + tx;
+			if ((vTileFlags[tile] & RASTER_TILE_COLOUR) == 0)
 			{
-				tex_u = (1.0f - t) * tex_su + t * tex_eu;
-				tex_v = (1.0f - t) * tex_sv + t * tex_ev;
-				tex_w = (1.0f - t) * tex_sw + t * tex_ew;
-				float* z = readDepthBuffer(i, j);
-				if (tex_w > * z)
-				{
-					colour_t colour = texture->lookUp(tex_u / tex_w, tex_v / tex_w);
-					drawPointP(j, i, colour);
-					*z = tex_w;
-				}
-				t += tstep;
+				continue;
 			}
 
+			const int x = tx * RASTER_BLOCK_SIZE;
+			untileRect(pixels + (size_t)y * width + x, width, vTiledColour.data() + tile * RASTER_TILE_PIXELS,
+				std::min(RASTER_BLOCK_SIZE, width - x), h);
+			vTileFlags[tile] &= ~RASTER_TILE_COLOUR;
 		}
 	}
 
-	dy1 = y3 - y2;
-	dx1 = x3 - x2;
-	dv1 = v3 - v2;
-	du1 = u3 - u2;
-	dw1 = w3 - w2;
-
-	if (dy1) dax_step = dx1 / (float)abs(dy1);
-	if (dy2) dbx_step = dx2 / (float)abs(dy2);
-
-	du1_step = 0, dv1_step = 0;
-	if (dy1) du1_step = du1 / (float)abs(dy1);
-	if (dy1) dv1_step = dv1 / (float)abs(dy1);
-	if (dy1) dw1_step = dw1 / (float)abs(dy1);
-
-	if (dy1)
+	for (RasterOutline& outline : vOutlines)
 	{
-		for (int i = y2; i <= y3; i++)
-		{
-			int ax = x2 + (int)((float)(i - y2) * dax_step);
-			int bx = x1 + (int)((float)(i - y1) * dbx_step);
-
-			float tex_su = u2 + (float)(i - y2) * du1_step;
-			float tex_sv = v2 + (float)(i - y2) * dv1_step;
-			float tex_sw = w2 + (float)(i - y2) * dw1_step;
-
-			float tex_eu = u1 + (float)(i - y1) * du2_step;
-			float tex_ev = v1 + (float)(i - y1) * dv2_step;
-			float tex_ew = w1 + (float)(i - y1) * dw2_step;
-
-			if (ax > bx)
-			{
-				std::swap(ax, bx);
-				std::swap(tex_su, tex_eu);
-				std::swap(tex_sv, tex_ev);
-				std::swap(tex_sw, tex_ew);
-			}
-
-			tex_u = tex_su;
-			tex_v = tex_sv;
-			tex_w = tex_sw;
-
-			float tstep = 1.0f / ((float)(bx - ax));
-			float t = 0.0f;
-
-			for (int j = ax; j < bx; j++)
-			{
-				tex_u = (1.0f - t) * tex_su + t * tex_eu;
-				tex_v = (1.0f - t) * tex_sv + t * tex_ev;
-				tex_w = (1.0f - t) * tex_sw + t * tex_ew;
-
-				float* z = readDepthBuffer(i, j);
-				if (tex_w > * z)
-				{
-					colour_t colour = texture->lookUp(tex_u / tex_w, tex_v / tex_w);
-					drawPointP(j, i, colour);
-					*z = tex_w;
-				}
-				t += tstep;
-			}
-		}
+		drawTriangleP(outline.v[0], outline.v[1], outline.v[2], outline.colour);
 	}
+	vOutlines.clear();
 }
 
 /**
@@ -630,7 +695,13 @@ void Graphics::drawTexturedTriangle(Triangle& triangle)
  *
  * Algorithm from: https://github.com/OneLoneCoder/videos/blob/master/OneLoneCoder_olcEngine3D_Part4.cpp
  *
- * Once Triangle data found and sorted, the triangles are drawn to the pBuffer using drawTexturedTriangle
+ * Meshes are ordered front to back by renderQueue (see 
+ * RasterOptions::frontToBack) unless presorted is set, in which case they
+ * are drawn in the order given. Once Triangle data found and sorted, the 
+ * triangles are drawn to the pBuffer using rasterTriangles
+ *
+ * \param presorted meshes are already in draw order (see 
+ * RenderCommandBuffer::sort)
  */
 bool Graphics::rasterTexturedTriangles(
 	const Matrix4x4& projectionMatrix,
@@ -639,317 +710,477 @@ bool Graphics::rasterTexturedTriangles(
 	const Vec4f& vLookDir,
 	ObjectHit& objectHit,
 	const float maxObjectHitDistance,
-	const std::vector<Object*> meshes,
-	const colour_t* strokeColour)
+	const std::vector<MeshInstance*>& meshes,
+	const colour_t* strokeColour,
+	const bool presorted)
 {
 	float distToObjectHit = maxObjectHitDistance;
 
+	// Objects front to back, so the depth test rejects hidden pixels before 
+	// they are textured
+	const std::vector<MeshInstance*>* objects = &meshes;
+	if (rasterOptions.frontToBack && !presorted)
+	{
+		PROFILE_SCOPE("Sort");
+		objects = &renderQueue.sort(meshes, vCamera);
+	}
+
 	// Triangles
 	std::vector<Triangle> trianglesToRaster;
-	for (auto objectMesh : meshes)
 	{
-		assert(objectMesh != nullptr);
-
-		//for (auto tri : objectMesh->vTris)
-		for (auto face : objectMesh->faces)  // draw cube
+		PROFILE_SCOPE("Transform");
+		for (auto objectMesh : *objects)
 		{
-			if (!face.draw)
+			assert(objectMesh != nullptr);
+			const Mesh* mesh = objectMesh->pMesh;
+			if (mesh == nullptr)
 			{
 				continue;
 			}
-			for (auto tri : face.vTris)
+
+			// Vertices are transformed when first used by this instance
+			if (vVertexCache.size() < mesh->vVertices.size())
+			{
+				vVertexCache.resize(mesh->vVertices.size());
+			}
+			if (++vertexStamp == 0)
 			{
-				Triangle triProjected, triTransformed, triCamera;
+				for (auto& vertex : vVertexCache)
+				{
+					vertex.stamp = 0;
+				}
+				vertexStamp = 1;
+			}
 
-				triTransformed.p[0] = objectMesh->matrixWorldPos * tri.p[0];
-				triTransformed.p[1] = objectMesh->matrixWorldPos * tri.p[1];
-				triTransformed.p[2] = objectMesh->matrixWorldPos * tri.p[2];
-				triTransformed.t[0] = tri.t[0];
-				triTransformed.t[1] = tri.t[1];
-				triTransformed.t[2] = tri.t[2];
-				triTransformed.parent = tri.parent;
+			uint faceStart = 0;
+			for (size_t face = 0; face < mesh->vFaceEnd.size(); face++)
+			{
+				const uint first = faceStart;
+				const uint last = mesh->vFaceEnd[face];
+				faceStart = last;
+				if (face < MESH_MAX_FACES && (objectMesh->faceMask & (1u << face)) == 0)
+				{
+					continue;
+				}
+				rasterStats.trianglesSubmitted += last - first;
+				for (uint i = first; i < last; i++)
+				{
+					const uint* indices = &mesh->vIndices[(size_t)i * 3];
+					const Vec3f* texCoords = &mesh->vTexCoords[(size_t)i * 3];
+					RasterVertex* corners[3];
+					for (int k = 0; k < 3; k++)
+					{
+						RasterVertex& vertex = vVertexCache[indices[k]];
+						if (vertex.stamp != vertexStamp)
+						{
+							vertex.world = objectMesh->matrixWorldPos * mesh->vVertices[indices[k]];
+							vertex.stamp = vertexStamp;
+							vertex.stages = 0;
+							rasterStats.verticesTransformed++;
+						}
+						corners[k] = &vertex;
+					}
 
-				Vec4f normal, line1, line2;
+					Triangle triProjected, triTransformed, triCamera;
 
-				line1 = triTransformed.p[1] - triTransformed.p[0];
-				line2 = triTransformed.p[2] - triTransformed.p[0];
+					triTransformed.p[0] = corners[0]->world;
+					triTransformed.p[1] = corners[1]->world;
+					triTransformed.p[2] = corners[2]->world;
+					triTransformed.t[0] = texCoords[0];
+					triTransformed.t[1] = texCoords[1];
+					triTransformed.t[2] = texCoords[2];
+					triTransformed.colour = mesh->colour;
+					triTransformed.parent = objectMesh;
 
-				normal = Vec4f::CrossProduct(line1, line2);
+					Vec4f normal, line1, line2;
 
-				normal.Normalise();
+					line1 = triTransformed.p[1] - triTransformed.p[0];
+					line2 = triTransformed.p[2] - triTransformed.p[0];
 
-				Vec4f vCameraRay;
-				vCameraRay = triTransformed.p[0] - vCamera;
+					normal = Vec4f::CrossProduct(line1, line2);
 
+					normal.Normalise();
 
-				/* Check collision with camera */
+					Vec4f vCameraRay;
+					vCameraRay = triTransformed.p[0] - vCamera;
 
 
+					/* Check collision with camera */
 
-				/* Test collision with look direction vector */
 
-				triTransformed.hit = false;
-				float t_, u, v;
-				Vec4f N;
 
-				if (intersectTriangle(vCamera, vLookDir, triTransformed.p[0], triTransformed.p[1], triTransformed.p[2], t_, u, v, N))
-				{
-					Vec4f vHit = vCamera + (vLookDir * t_);
-					float dist = Vec4f::Distance(vCamera, vHit);
-					if (dist < distToObjectHit)
+					/* Test collision with look direction vector */
+
+					triTransformed.hit = false;
+					float t_, u, v;
+					Vec4f N;
+
+					if (intersectTriangle(vCamera, vLookDir, triTransformed.p[0], triTransformed.p[1], triTransformed.p[2], t_, u, v, N))
 					{
-						distToObjectHit = dist;
-						objectHit.fFistanceFromCamera = dist;
-						objectHit.objectHit = objectMesh;
-						objectHit.triangleHit = &tri;
-						objectHit.vPoint = vHit;
-						objectHit.vNormal = normal;
-
-						//triTransformed.colour = 0xff0000;
-						triTransformed.hit = true;
+						Vec4f vHit = vCamera + (vLookDir * t_);
+						float dist = Vec4f::Distance(vCamera, vHit);
+						if (dist < distToObjectHit)
+						{
+							distToObjectHit = dist;
+							objectHit.fFistanceFromCamera = dist;
+							objectHit.objectHit = objectMesh;
+							objectHit.triangleHit = (int)i;
+							objectHit.vPoint = vHit;
+							objectHit.vNormal = normal;
+
+							//triTransformed.colour = 0xff0000;
+							triTransformed.hit = true;
+						}
 					}
-				}
 
-				if (Vec4f::DotProduct(normal, vCameraRay) < 0.0f)
-				{
-					// Shade triangle
-					//Vec4f vLightDir = { 0.0f, 1.0f, -1.0f };
-					//vLightDir.Normalise();
-					//float dp = std::max(0.1f, Vec4f::DotProduct(vLightDir, normal));
-
-					//triCamera.colour = (colour_t)(((dp * 255.0f) * 3.0f) / 5.0f);
-					//triCamera.colour = triTransformed.colour;
-					triCamera.hit = triTransformed.hit;
-					triCamera.p[0] = matrixCamera * triTransformed.p[0];
-					triCamera.p[1] = matrixCamera * triTransformed.p[1];
-					triCamera.p[2] = matrixCamera * triTransformed.p[2];
-					triCamera.t[0] = triTransformed.t[0];
-					triCamera.t[1] = triTransformed.t[1];
-					triCamera.t[2] = triTransformed.t[2];
-					triCamera.parent = triTransformed.parent;
-
-					int nClippedTriangles = 0;
-					Triangle clipped[2];
-					nClippedTriangles = TriangleClipAgainstPlane({ 0.0f, 0.0f, 0.1f }, { 0.0f, 0.0f, 1.0f }, triCamera, clipped[0], clipped[1]);
-
-					for (int n = 0; n < nClippedTriangles; n++)
+					if (Vec4f::DotProduct(normal, vCameraRay) < 0.0f)
 					{
-						triProjected.p[0] = projectionMatrix * clipped[n].p[0];
-						triProjected.p[1] = projectionMatrix * clipped[n].p[1];
-						triProjected.p[2] = projectionMatrix * clipped[n].p[2];
-						//triProjected.colour = clipped[n].colour;
-						triProjected.hit = clipped[n].hit;
-						triProjected.t[0] = clipped[n].t[0];
-						triProjected.t[1] = clipped[n].t[1];
-						triProjected.t[2] = clipped[n].t[2];
-						triProjected.parent = clipped[n].parent;
-
-
-						triProjected.t[0].u /= triProjected.p[0].w;
-						triProjected.t[1].u /= triProjected.p[1].w;
-						triProjected.t[2].u /= triProjected.p[2].w;
-
-						triProjected.t[0].v /= triProjected.p[0].w;
-						triProjected.t[1].v /= triProjected.p[1].w;
-						triProjected.t[2].v /= triProjected.p[2].w;
-
-						triProjected.t[0].w = 1.0f / triProjected.p[0].w;
-						triProjected.t[1].w = 1.0f / triProjected.p[1].w;
-						triProjected.t[2].w = 1.0f / triProjected.p[2].w;
-
-
-						triProjected.p[0] /= triProjected.p[0].w;
-						triProjected.p[1] /= triProjected.p[1].w;
-						triProjected.p[2] /= triProjected.p[2].w;
-
-						// Invert
-						triProjected.p[0].x *= -1;
-						triProjected.p[1].x *= -1;
-						triProjected.p[2].x *= -1;
-
-						Vec4f vOffsetView = { 1, 1, 0 };
-						triProjected.p[0] += vOffsetView;
-						triProjected.p[1] += vOffsetView;
-						triProjected.p[2] += vOffsetView;
-						triProjected.p[0].x *= 0.5f * (float)width;
-						triProjected.p[0].y *= 0.5f * (float)height;
-						triProjected.p[1].x *= 0.5f * (float)width;
-						triProjected.p[1].y *= 0.5f * (float)height;
-						triProjected.p[2].x *= 0.5f * (float)width;
-						triProjected.p[2].y *= 0.5f * (float)height;
-
-						trianglesToRaster.push_back(triProjected);
+						// Shade triangle
+						//Vec4f vLightDir = { 0.0f, 1.0f, -1.0f };
+						//vLightDir.Normalise();
+						//float dp = std::max(0.1f, Vec4f::DotProduct(vLightDir, normal));
+
+						//triCamera.colour = (colour_t)(((dp * 255.0f) * 3.0f) / 5.0f);
+						bool inFront = true;
+						for (int k = 0; k < 3; k++)
+						{
+							if ((corners[k]->stages & RASTER_VERTEX_CAMERA) == 0)
+							{
+								corners[k]->camera = matrixCamera * corners[k]->world;
+								corners[k]->stages |= RASTER_VERTEX_CAMERA;
+							}
+							inFront &= corners[k]->camera.z >= RASTER_NEAR_PLANE;
+						}
+
+						if (inFront)
+						{
+							// Nothing to clip, corners are projected once
+							for (int k = 0; k < 3; k++)
+							{
+								RasterVertex& vertex = *corners[k];
+								if ((vertex.stages & RASTER_VERTEX_SCREEN) == 0)
+								{
+									vertex.w = projectToScreen(projectionMatrix, vertex.camera, vertex.screen);
+									vertex.stages |= RASTER_VERTEX_SCREEN;
+								}
+								triProjected.p[k] = vertex.screen;
+								triProjected.t[k].u = texCoords[k].u / vertex.w;
+								triProjected.t[k].v = texCoords[k].v / vertex.w;
+								triProjected.t[k].w = 1.0f / vertex.w;
+							}
+							triProjected.colour = triTransformed.colour;
+							triProjected.hit = triTransformed.hit;
+							triProjected.parent = triTransformed.parent;
+
+							trianglesToRaster.push_back(triProjected);
+							continue;
+						}
+
+						triCamera.colour = triTransformed.colour;
+						triCamera.hit = triTransformed.hit;
+						triCamera.p[0] = corners[0]->camera;
+						triCamera.p[1] = corners[1]->camera;
+						triCamera.p[2] = corners[2]->camera;
+						triCamera.t[0] = triTransformed.t[0];
+						triCamera.t[1] = triTransformed.t[1];
+						triCamera.t[2] = triTransformed.t[2];
+						triCamera.parent = triTransformed.parent;
+
+						int nClippedTriangles = 0;
+						Triangle clipped[2];
+						nClippedTriangles = TriangleClipAgainstPlane({ 0.0f, 0.0f, RASTER_NEAR_PLANE }, { 0.0f, 0.0f, 1.0f }, triCamera, clipped[0], clipped[1]);
+
+						for (int n = 0; n < nClippedTriangles; n++)
+						{
+							for (int k = 0; k < 3; k++)
+							{
+								const float w = projectToScreen(projectionMatrix, clipped[n].p[k], triProjected.p[k]);
+								triProjected.t[k].u = clipped[n].t[k].u / w;
+								triProjected.t[k].v = clipped[n].t[k].v / w;
+								triProjected.t[k].w = 1.0f / w;
+							}
+							triProjected.colour = clipped[n].colour;
+							triProjected.hit = clipped[n].hit;
+							triProjected.parent = clipped[n].parent;
+
+							trianglesToRaster.push_back(triProjected);
+						}
 					}
 				}
 			}
 		}
 	}
-		
 
-	//if (fill)
-	//{
-	//	// Sort triangles from back to front
-	//	sort(trianglesToRaster.begin(), trianglesToRaster.end(), [](Triangle& t1, Triangle& t2)
-	//		{
-	//			float z1 = (t1.p[0].z + t1.p[1].z + t1.p[2].z) / 3.0f;
-	//			float z2 = (t2.p[0].z + t2.p[1].z + t2.p[2].z) / 3.0f;
-	//			return z1 > z2;
-	//		});
-	//}
-
-	for (auto& triToRaster : trianglesToRaster)
+	// Clip triangles against the borders of the screen
+	std::vector<Triangle> trianglesClipped;
 	{
-		Triangle clipped[2];
-		std::list<Triangle> listTriangles;
-		listTriangles.push_back(triToRaster);
-		int newTriangles = 1;
-
-		for (int p = 0; p < 4; p++)
+		PROFILE_SCOPE("Clip");
+		trianglesClipped.reserve(trianglesToRaster.size());
+		for (auto& triToRaster : trianglesToRaster)
 		{
-			int trianglesToAdd = 0;
-			while (newTriangles > 0)
+			Triangle clipped[2];
+			std::list<Triangle> listTriangles;
+			listTriangles.push_back(triToRaster);
+			int newTriangles = 1;
+
+			for (int p = 0; p < 4; p++)
 			{
-				Triangle test = listTriangles.front();
-				listTriangles.pop_front();
-				newTriangles--;
-
-				// Clipping planes (borders of the screen)
-				Vec4f pTop(0.0f, 0.0f, 0.0f);
-				Vec4f pBottom(0.0f, (float)height - 1.0f, 0.0f);
-				Vec4f pLeft(0.0f, 0.0f, 0.0f);
-				Vec4f pRight((float)width - 1.0f, 0.0f, 0.0f);
-
-				// Normals (facing into screen boundary)
-				Vec4f nDownwards(0.0f, 1.0f, 0.0f);
-				Vec4f nUpwards(0.0f, -1.0f, 0.0f);
-				Vec4f nRight(1.0f, 0.0f, 0.0f);
-				Vec4f nLeft(-1.0f, 0.0f, 0.0f);
-
-				switch (p)
+				int trianglesToAdd = 0;
+				while (newTriangles > 0)
 				{
-				case 0:	trianglesToAdd = TriangleClipAgainstPlane(pTop,	   nDownwards, test, clipped[0], clipped[1]); break;
-				case 1:	trianglesToAdd = TriangleClipAgainstPlane(pBottom, nUpwards, test, clipped[0], clipped[1]); break;
-				case 2:	trianglesToAdd = TriangleClipAgainstPlane(pLeft,   nRight, test, clipped[0], clipped[1]); break;
-				case 3:	trianglesToAdd = TriangleClipAgainstPlane(pRight,  nLeft, test, clipped[0], clipped[1]); break;
-				}
+					Triangle test = listTriangles.front();
+					listTriangles.pop_front();
+					newTriangles--;
+
+					// Clipping planes (borders of the screen)
+					Vec4f pTop(0.0f, 0.0f, 0.0f);
+					Vec4f pBottom(0.0f, (float)height - 1.0f, 0.0f);
+					Vec4f pLeft(0.0f, 0.0f, 0.0f);
+					Vec4f pRight((float)width - 1.0f, 0.0f, 0.0f);
+
+					// Normals (facing into screen boundary)
+					Vec4f nDownwards(0.0f, 1.0f, 0.0f);
+					Vec4f nUpwards(0.0f, -1.0f, 0.0f);
+					Vec4f nRight(1.0f, 0.0f, 0.0f);
+					Vec4f nLeft(-1.0f, 0.0f, 0.0f);
+
+					switch (p)
+					{
+					case 0:	trianglesToAdd = TriangleClipAgainstPlane(pTop,	   nDownwards, test, clipped[0], clipped[1]); break;
+					case 1:	trianglesToAdd = TriangleClipAgainstPlane(pBottom, nUpwards, test, clipped[0], clipped[1]); break;
+					case 2:	trianglesToAdd = TriangleClipAgainstPlane(pLeft,   nRight, test, clipped[0], clipped[1]); break;
+					case 3:	trianglesToAdd = TriangleClipAgainstPlane(pRight,  nLeft, test, clipped[0], clipped[1]); break;
+					}
 
-				for (int w = 0; w < trianglesToAdd; w++)
-				{
-					clipped[w].parent = triToRaster.parent;
-					listTriangles.push_back(clipped[w]);
+					for (int w = 0; w < trianglesToAdd; w++)
+					{
+						clipped[w].parent = triToRaster.parent;
+						listTriangles.push_back(clipped[w]);
+					}
 				}
+				newTriangles = (int)listTriangles.size();
 			}
-			newTriangles = (int)listTriangles.size();
-		}
 
-		for (auto& t : listTriangles)
-		{
-			//if (fill)
-			//{
-			//	FillTriangleP(
-			//		t.p[0].x, t.p[0].y, 
-			//		t.p[1].x, t.p[1].y, 
-			//		t.p[2].x, t.p[2].y,
-			//		t.colour);
-			//}
-
-			if (t.parent == nullptr)
-			{
-				// error
-			}
+			trianglesClipped.insert(trianglesClipped.end(), listTriangles.begin(), listTriangles.end());
+		}
+	}
 
-			drawTexturedTriangle(t);
+	{
+		PROFILE_SCOPE("Raster");
+		rasterStats.trianglesRasterised += trianglesClipped.size();
 
-			if ((strokeColour != nullptr) || t.hit)
-			{
-				Vec2 v1_ = { (int)t.p[0].x, (int)t.p[0].y };
-				Vec2 v2_ = { (int)t.p[1].x, (int)t.p[1].y };
-				Vec2 v3_ = { (int)t.p[2].x, (int)t.p[2].y };
-				//drawTriangleP(v1_, v2_, v3_, *strokeColour);
-				drawTriangleP(v1_, v2_, v3_, 0xff0000);
-			}
+		// Depth first, so each pixel is then textured once
+		const bool prepass = rasterOptions.depthPrepass && rasterOptions.depthTest;
+		if (prepass)
+		{
+			rasterDepth(trianglesClipped.data(), trianglesClipped.size());
 		}
+		rasterTriangles(trianglesClipped.data(), trianglesClipped.size(), strokeColour, prepass);
+	}
+
+	{
+		PROFILE_SCOPE("Resolve");
+		resolveRasterTargets();
 	}
 
 	return (distToObjectHit < maxObjectHitDistance);
 }
 
 /**
- * \brief Draws solid colour string to pBuffer using drawChar.
+ * \brief Draws solid colour string to pBuffer.
  * 
  * \param str String to be drawn
  * \param v Vec2 where x, y corresspond to bottom-left of area to draw to
  * \param colour Colour of text
+ * 
+ * \see drawGlyphRun
  */
-void Graphics::drawText(std::string str, Vec2 v, const colour_t colour)
+void Graphics::drawText(const std::string& str, Vec2 v, const colour_t colour)
 {
-	// assert ...
+	drawGlyphRun(str.data(), str.size(), v, colour);
+}
 
-	for (std::string::size_type i = 0; i < str.size(); i++)
+/**
+ * \brief (GUI Implementation of drawText) Draws solid colour string to pBuffer
+ * from the retained layout of guiText.
+ * 
+ * \param guiText Object which describes the graphical representation to be drawn.
+ * 
+ * \see GUIText, layoutText
+ */
+void Graphics::drawText(const GUIText& guiText)
+{
+	if (!layoutText(guiText))
 	{
-		if (v.x >= width)
-		{
-			return;  // Stop drawing when screen boundary is encountered
-		}
-		drawChar(str[i], v, colour);
-		v.x += 14;  // TODO ind_x
+		return;
 	}
+
+	const colour_t colour = guiText.colourPallete[static_cast<int>(guiText.state)];
+	drawTextLayout(guiText.layout, screenToPx(guiText.vf1), colour);
 }
 
 /**
- * \brief (GUI Implementation of drawText) Draws solid colour string to pBuffer using drawChar.
+ * \brief Updates guiText.layout with the text to be drawn for guiText.
  * 
- * \param guiText Object which describes the graphical representation to be drawn.
+ * Text input is cut off at the start if it would overflow vf2. The layout
+ * is only rebuilt when the resulting text changes.
  * 
- * \see GUIText
+ * \param guiText Object which describes the graphical representation to be drawn.
+ * \return Returns false if there is no text to draw, otherwise true
  */
-void Graphics::drawText(const GUIText guiText)
+const bool Graphics::layoutText(const GUIText& guiText)
 {
 	// assert ...
 	Vec2 vPos = screenToPx(guiText.vf1);
 	Vec2 vMax = screenToPx(guiText.vf2);
 
-	std::string txt;
 	if (guiText.pText == nullptr && guiText.sText.empty())
-		return;
+		return false;
 	else if (guiText.pText == nullptr)
-		txt = guiText.sText;
+	{
+		// Static label, laid out once
+		guiText.layout.setText(guiText.sText);
+		guiText.layout.layout(*text2D);
+		return true;
+	}
+
+	std::string txt = guiText.sText;
+
+	std::string sTrailing = "_";
+	std::string fill = ".. ";
+
+	// Cut off beginning of pText if it flows off end of rect
+	if ((guiText.sText.size() * 14u) + (guiText.pText->size() * 14u) + (sTrailing.size() * 14u) >= vMax.x - vPos.x)
+	{
+		int num_chars_that_fit = ((vMax.x - vPos.x) / 14) - (int)guiText.sText.size();
+		//int difference = guiText.pText->size() - num_chars_that_fit;
+		
+		txt += fill;
+		num_chars_that_fit -= (int)fill.size();
+		num_chars_that_fit -= (int)sTrailing.size();
+		
+		txt += guiText.pText->substr(guiText.pText->size() - num_chars_that_fit, num_chars_that_fit);
+	}
 	else
 	{
-		txt = guiText.sText;
+		txt += *guiText.pText;
+	}
+
+	txt += sTrailing;
 
-		std::string sTrailing = "_";
-		std::string fill = ".. ";
+	// Input text, laid out again only when typed text changes
+	guiText.layout.setText(txt);
+	guiText.layout.layout(*text2D);
+	return true;
+}
 
-		// Cut off beginning of pText if it flows off end of rect
-		if ((guiText.sText.size() * 14u) + (guiText.pText->size() * 14u) + (sTrailing.size() * 14u) >= vMax.x - vPos.x)
+/**
+ * \brief Draws a TextLayout, laying it out first if its content changed.
+ * 
+ * \param layout Text to be drawn
+ * \param v Vec2 where x, y corresspond to bottom-left of area to draw to
+ * \param colour Colour of text
+ * 
+ * \see TextLayout
+ */
+void Graphics::drawTextLayout(TextLayout& layout, Vec2 v, const colour_t colour)
+{
+	layout.layout(*text2D);
+
+	colour_t* pixels = (colour_t*)pBuffer;
+	for (auto& run : layout.getRuns())
+	{
+		const int y = v.y + run.y;
+		if (y < 0 || y >= height)
 		{
-			int num_chars_that_fit = ((vMax.x - vPos.x) / 14) - (int)guiText.sText.size();
-			//int difference = guiText.pText->size() - num_chars_that_fit;
-			
-			txt += fill;
-			num_chars_that_fit -= (int)fill.size();
-			num_chars_that_fit -= (int)sTrailing.size();
-			
-			txt += guiText.pText->substr(guiText.pText->size() - num_chars_that_fit, num_chars_that_fit);
+			continue;
 		}
-		else
+
+		int x1 = v.x + run.x;
+		int x2 = x1 + run.length;
+		if (x1 < 0)
 		{
-			txt += *guiText.pText;
+			x1 = 0;
+		}
+		if (x2 > width)
+		{
+			x2 = width;
 		}
 
-		txt += sTrailing;
+		colour_t* pixel = pixels + y * width;
+		for (int x = x1; x < x2; x++)
+		{
+			pixel[x] = colour;
+		}
+	}
+}
+
+/**
+ * \brief Draws a run of characters from the glyph cache of text2D.
+ * 
+ * Rows and columns are clipped to the buffer once for the whole run, so 
+ * each visible glyph row is written directly without per pixel clamping.
+ * Chars which are not accepted are skipped but still advance the pen.
+ * 
+ * \param str Characters to be drawn (need not be null terminated)
+ * \param length Number of characters in str
+ * \param v Vec2 where x, y corresspond to bottom-left of area to draw to
+ * \param colour Colour of text
+ * 
+ * \see Text2D::getGlyph
+ */
+void Graphics::drawGlyphRun(const char* str, const size_t length, Vec2 v, const colour_t colour)
+{
+	// Rows visible for every glyph in the run
+	const int rowStart = v.y < 0 ? -v.y : 0;
+	const int rowEnd = height - v.y < TEXT2D_GLYPH_ROWS ? height - v.y : TEXT2D_GLYPH_ROWS;
+	if (rowStart >= rowEnd)
+	{
+		return;
+	}
+
+	// Skip chars left of the buffer and stop at the right edge
+	size_t first = 0;
+	if (v.x < 0)
+	{
+		first = (size_t)((-v.x) / TEXT2D_GLYPH_WIDTH);
+	}
+	size_t last = length;
+	const int maxChars = (width - v.x + TEXT2D_GLYPH_WIDTH - 1) / TEXT2D_GLYPH_WIDTH;
+	if (maxChars <= 0)
+	{
+		return;
+	}
+	if ((size_t)maxChars < last)
+	{
+		last = (size_t)maxChars;
 	}
 
-	for (std::string::size_type i = 0; i < txt.size(); i++)
+	colour_t* pixels = (colour_t*)pBuffer;
+	for (size_t i = first; i < last; i++)
 	{
-		if (vPos.x >= width)  // || iPosY <= iMaxY)
+		const int x = v.x + (int)i * TEXT2D_GLYPH_WIDTH;
+		const Glyph* glyph = text2D->getGlyph(str[i]);
+		if (glyph == nullptr)
 		{
-			return;  // Stop drawing when screen boundary is encountered
+			continue;
 		}
 
-		drawChar(txt[i], vPos, guiText.colourPallete[static_cast<int>(guiText.state)]);
-		vPos.x += 14;  // TODO ind_x
+		const int colStart = x < 0 ? -x : 0;
+		const int colEnd = width - x < TEXT2D_GLYPH_WIDTH ? width - x : TEXT2D_GLYPH_WIDTH;
+
+		for (int row = rowStart; row < rowEnd; row++)
+		{
+			const uint8* coverage = glyph->coverage[row];
+			colour_t* pixel = pixels + (v.y + row) * width + x;
+			for (int col = colStart; col < colEnd; col++)
+			{
+				if (coverage[col])
+				{
+					pixel[col] = colour;
+				}
+			}
+		}
 	}
 }
 
@@ -965,47 +1196,12 @@ void Graphics::drawText(const GUIText guiText)
  */
 const bool Graphics::drawChar(const char c, Vec2& v, const colour_t colour)
 {
-	// assert ...
-
-	// Check acceptable character
-	int charIndex = (int)text2D->acceptedChars.find(c);
-	if (charIndex == std::string::npos)
+	if (text2D->getGlyph(c) == nullptr)
 	{
 		return false;
 	}
 
-	// Find char in texture
-	int num_elements_x = 18;
-	int ind_x = charIndex % num_elements_x;
-	int ind_y = (int)floor((charIndex) / (num_elements_x));
-
-	// Size of char in texture
-	const int size_x = 14;
-	const int size_y = 18;
-
-	const int top = (text2D->height - 1) - (size_y * ind_y);  // max textTexture->height - 1; min 0
-	const int bottom = top - size_y;  // min 0  (clamp etc.)
-	const int left = size_x * ind_x;  // min 0; max textTexture->width - size_x
-	const int right = left + size_x;  // max textTexture->width
-
-	//DrawRectP(posX, posY, posX + size_x, posY + size_y, 0xff0000);  // test boundaries
-
-	for (int y = top; y >= bottom; y--)
-	{
-		for (int x = left; x < right; x++)
-		{
-			int pos = y * text2D->linesize + x / 8;
-			int bit = 1 << (7 - x % 8);
-			if ((text2D->pCharMap[pos] & bit) > 0)
-			{
-				drawPointP(v.x + (x - left), v.y + (y - bottom), colour);
-			}
-				//DrawPointP(posX + (x - left), posY + (y - bottom), text2D->colortable[1]);
-			//else  // draw background
-				//DrawPointP(posX + (x - left), posY + (y - bottom), textTexture->colortable[0]);
-		}
-	}
-
+	drawGlyphRun(&c, 1, v, colour);
 	return true;
 }
 
@@ -1056,28 +1252,25 @@ void Graphics::drawGUIMenuSprite(GUISprite* guiSprite)
 {
 	Vec2 v1 = screenToPx(guiSprite->vf1);
 	Vec2 v2 = screenToPx(guiSprite->vf2);
-	
-	for (int j = v1.y; j < v2.y; j++)
+	const int w = v2.x - v1.x;
+	const int h = v2.y - v1.y;
+
+	if (!guiSprite->isCacheValid(w, h, sizeGeneration))
 	{
-		for (int i = v1.x; i < v2.x; i++)
-		{
-			const float x_ = normalise((float)i, (float)v1.x, (float)v2.x);
-			const float y_ = normalise((float)j, (float)v1.y, (float)v2.y);
+		guiSprite->updateCache(w, h, sizeGeneration);
+	}
 
-			Texture* tex = guiSprite->Tex();
-			switch (tex->textureType)
-			{
-			case TextureType::RGB:
-				drawPointP(i, j, (tex->lookUp(x_, y_, guiSprite->getState())));
-				break;
-			case TextureType::RGBA:
-				drawPointPAlpha(i, j, (tex->lookUp(x_, y_, guiSprite->getState())));
-				break;
-			default:
-				//std::cerr << "Error at drawGUIMenuSprite() -> Unknown texture type\n";
-				return;
-			}
-		}
+	switch (guiSprite->Tex()->textureType)
+	{
+	case TextureType::RGB:
+		blit(guiSprite->getCachedState(), w, h, v1, BlitMode::Copy);
+		break;
+	case TextureType::RGBA:
+		blit(guiSprite->getCachedState(), w, h, v1, BlitMode::Blend);
+		break;
+	default:
+		//std::cerr << "Error at drawGUIMenuSprite() -> Unknown texture type\n";
+		return;
 	}
 }
 
@@ -1101,11 +1294,17 @@ Graphics::Sprite::~Sprite()
 	}
 	if (pData != nullptr)
 	{
-		delete pData;
+		delete[] (colour_t*)pData;
 		pData = nullptr;
 	}
 }
 
+/**
+ * \brief Rescales texture into pData at the sprite's size in screen 
+ * pixels. Called when the screen changes size.
+ * 
+ * RGBA sprites are stored premultiplied so they can be blended directly.
+ */
 void Graphics::Sprite::updateSize()
 {
 	if (pTexture == nullptr)
@@ -1114,7 +1313,7 @@ void Graphics::Sprite::updateSize()
 	}
 	if (pData != nullptr)
 	{
-		delete pData;
+		delete[] (colour_t*)pData;
 		pData = nullptr;
 	}
 
@@ -1124,6 +1323,8 @@ void Graphics::Sprite::updateSize()
 	int w = v2.x - v1.x;
 	int h = v2.y - v1.y;
 	int size = w * h * pTexture->maxCylcesX * pTexture->maxCylcesY;
+	dataWidth = w;
+	dataHeight = h;
 
 	pData = new colour_t[size];
 
@@ -1142,36 +1343,31 @@ void Graphics::Sprite::updateSize()
 			}
 		}
 	}
-}
 
+	if (pTexture->textureType == TextureType::RGBA)
+	{
+		premultiplyAlpha((colour_t*)pData, size);
+	}
+}
 
+/**
+ * \brief Draws pData to the parent's pBuffer. RGB sprites are copied and
+ * RGBA sprites are alpha blended.
+ */
 void Graphics::Sprite::draw()
 {
-	Vec2 v1 = parent.screenToPx(vf1);
-	Vec2 v2 = parent.screenToPx(vf2);
-	clamp(&v1.x, 0, parent.width);
-	clamp(&v2.x, 0, parent.width);
-	clamp(&v1.y, 0, parent.height);
-	clamp(&v2.y, 0, parent.height);
-	const uint bufferWidth = v2.x - v1.x;
+	const Vec2 v1 = parent.screenToPx(vf1);
 
-	colour_t* pixel = (colour_t*)parent.pBuffer;
 	switch (pTexture->textureType)
 	{
 	case TextureType::RGB:
-	{
-		for (int y = v1.y; y < v2.y; y++)
-			for (int x = v1.x; x < v2.x; x++)
-				parent.drawPointP(x, y, reinterpret_cast<colour_t*>(pData)[(x - v1.x) + ((y - v1.y) * bufferWidth)]);
-	} break;
+		parent.blit((const colour_t*)pData, dataWidth, dataHeight, v1, BlitMode::Copy);
+		break;
 	case TextureType::RGBA:
-	{
-		for (int y = v1.y; y < v2.y; y++)
-			for (int x = v1.x; x < v2.x; x++)
-				parent.drawPointPAlpha(x, y, reinterpret_cast<colour_t*>(pData)[(x - v1.x) + ((y - v1.y) * bufferWidth)]);
-	} break;
+		parent.blit((const colour_t*)pData, dataWidth, dataHeight, v1, BlitMode::Blend);
+		break;
 	default:
 		//error
 		return;
 	}
-}
\ No newline at end of file
+}
@@ -12,9 +12,14 @@
 #include "types.h"
 #include "graphics_ui.h"
 #include "graphics_text2d.h"
+#include "graphics_textlayout.h"
 #include "utils_vector.h"
 #include "graphics_texture.h"
+#include "graphics_blit.h"
 #include "graphics_objects.h"
+#include "graphics_raster.h"
+#include "graphics_renderqueue.h"
+#include <cstdint>
 #include <string>
 
 #define UINT32_RGB_CHANNEL   ((colour_t)0x00FFFFFF)	///< Hex bitmap for rgb 
@@ -27,11 +32,33 @@
 #define MAX_OBJECT_DISTANCE (float)(9999.0f)
 
 class Text2D;
+class Profiler;
+struct ProfileSummary;
 struct GUIText;
 class GUIForm;
 class GUIMenu;
 struct GUISprite;
 
+/**
+ * \brief Counters accumulated by the 3D rasteriser.
+ * 
+ * Reset by the caller (see Graphics::resetRasterStats) so they can cover a 
+ * single frame or a whole benchmark run.
+ */
+struct RasterStats
+{
+	uint64_t trianglesSubmitted = 0;	///< Triangles given to rasterTexturedTriangles
+	uint64_t trianglesRasterised = 0;	///< Triangles drawn after culling/clipping
+	uint64_t pixelsTested = 0;			///< Pixels depth tested
+	uint64_t pixelsWritten = 0;			///< Pixels which passed the depth test
+	uint64_t pixelsOverdrawn = 0;		///< Pixels covered again since 
+										///< clearDepthBuffer (see 
+										///< RasterOptions::countOverdraw)
+	uint64_t trianglesHidden = 0;		///< Triangles skipped by tile depth 
+										///< bounds (see RasterOptions::depthBounds)
+	uint64_t verticesTransformed = 0;	///< Mesh vertices moved to world space,
+										///< once per instance that uses them
+};
 
 /**
  * \brief Graphics class to handle drawing to screen buffers.
@@ -43,15 +70,21 @@ struct GUISprite;
  */
 class Graphics
 {
+	friend class UICompositor;
+
 public:
 	~Graphics();
 protected:
-	int width;			///< width of area to draw to
-	int height;			///< height of area to draw to
-	void* pBuffer;		///< pixel buffer in which to draw
-	void* pDepthBuffer;	///< memory in which to store depth values
-						///< corresponding to pBuffer. Used 
-						///< for 3D applications.
+	int width = 0;					///< width of area to draw to
+	int height = 0;					///< height of area to draw to
+	void* pBuffer = nullptr;		///< pixel buffer in which to draw
+	void* pDepthBuffer = nullptr;	///< memory in which to store depth values
+									///< corresponding to pBuffer. Used 
+									///< for 3D applications.
+	uint sizeGeneration = 0;		///< Incremented every time the buffers 
+									///< change size
+
+	void onSizeChanged();
 
 public:
 	class Sprite
@@ -62,6 +95,9 @@ public:
 		Vec2f vf2;								///< Top-right coords
 		Texture* pTexture = nullptr;			///< Pointer to the texture of sprite
 		void* pData = nullptr;					///< Pointer to pixel buffer relative to screen
+												///< (premultiplied alpha for RGBA)
+		int dataWidth = 0;						///< Width of pData in pixels
+		int dataHeight = 0;						///< Height of pData in pixels
 
 		Sprite(Graphics& parent, const char* filename, TextureType textureType, const int sectionWidth, const int sectionHeight,
 			const Vec2f vf1, const Vec2f vf2);
@@ -89,6 +125,7 @@ public:
 
 	int getWidth() { return width; }
 	int getHeight() { return height; }
+	uint getSizeGeneration() const { return sizeGeneration; }
 
 	static inline int screenToPx(const float a, const float b);
 	static inline float pxToScreen(const int a, const int b);
@@ -99,13 +136,15 @@ public:
 	void drawLineP(Vec2& v1, Vec2& v2, colour_t colour);
 	void drawTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, const colour_t colour);
 	void fillTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour);
-	void fillTopFlatTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour);
-	void fillBottomFlatTriangleP(Vec2& v1, Vec2& v2, Vec2& v3, colour_t colour);
+	void fillTriangle(const Triangle& triangle, const colour_t colour);
 
 public:
 	void drawFPS(const float fFPS, const colour_t colour);
 	void drawPos(const Vec4f vCamera, const Vec4f vVelocity, const uint accelerationFlags, const float fYaw, const float fPitch, const colour_t colour);
+	void drawProfiler(const Profiler& profiler, const colour_t colour);
+	void drawProfiler(const float fFrameMs, const std::vector<ProfileSummary>& vSummary, const colour_t colour);
 	void drawColourBuffer(void* buffer, const Vec2f vf1, const Vec2f vf2);
+	void blit(const colour_t* src, const int srcWidth, const int srcHeight, const Vec2 v, const BlitMode mode);
 
 	void clearScreen(colour_t colour);
 	void drawPointP(uint x, uint y, colour_t colour);
@@ -114,9 +153,16 @@ public:
 	void drawRect(const Vec2f& vf1, const Vec2f& vf2, colour_t colour);
 
 	// 3D
+	RasterStats rasterStats;
+	RasterOptions rasterOptions;
+	void resetRasterStats() { rasterStats = RasterStats(); }
 	void clearDepthBuffer();
+	void resolveRasterTargets();
 	float* readDepthBuffer(const uint x, const uint y);
 	void drawTexturedTriangle(Triangle& triangle);
+	void rasterTriangles(const Triangle* triangles, const size_t count, const colour_t* strokeColour = nullptr,
+		const bool prepassed = false);
+	void rasterDepth(const Triangle* triangles, const size_t count);
 	bool rasterTexturedTriangles(
 		const Matrix4x4& projectionMatrix,
 		const Matrix4x4& matrixCamera,
@@ -124,17 +170,94 @@ public:
 		const Vec4f& vLookDir,  // new
 		ObjectHit& objectHit,
 		const float maxObjectHitDistance,
-		const std::vector<Object*> meshes,
-		const colour_t* strokeColour = nullptr);
+		const std::vector<MeshInstance*>& meshes,
+		const colour_t* strokeColour = nullptr,
+		const bool presorted = false);
 
 public:
 	// GUI
-	Text2D* text2D;
-	void drawText(std::string str, Vec2 v, const colour_t colour);
-	void drawText(const GUIText guiText);
+	Text2D* text2D = nullptr;
+	void drawText(const std::string& str, Vec2 v, const colour_t colour);
+	void drawText(const GUIText& guiText);
+	const bool layoutText(const GUIText& guiText);
+	void drawGlyphRun(const char* str, const size_t length, Vec2 v, const colour_t colour);
+	void drawTextLayout(TextLayout& layout, Vec2 v, const colour_t colour);
 	const bool drawChar(const char c, Vec2& v, const colour_t colour);
 
 	void drawGUIForm(GUIForm* guiForm);
 	void drawGUIMenu(GUIMenu* guiMenu);
 	void drawGUIMenuSprite(GUISprite* guiSprite);
+
+private:
+	void fillTriangleSpans(const Vec2 v[3], const colour_t colour);
+
+	// Raster pipeline variants (graphics_raster.cpp)
+	typedef void (Graphics::* RasterBatchFunc)(const Triangle* triangles, const size_t count, const colour_t strokeColour);
+	static const RasterBatchFunc rasterBatchFuncs[3][3][2][2];
+	RasterBatchFunc selectRasterBatch(const MeshInstance* parent, const bool wireframe, const bool prepassed = false) const;
+
+	template <RasterFill Fill, RasterDepth Depth, bool AlphaTest, bool Wireframe>
+	void rasterBatch(const Triangle* triangles, const size_t count, const colour_t strokeColour);
+	template <RasterFill Fill, RasterDepth Depth, bool AlphaTest>
+	void rasterTriangle(const Triangle& triangle, const colour_t colour, RasterStats& counts);
+	template <RasterFill Fill, RasterDepth Depth, bool AlphaTest>
+	void rasterTexturedSpan(colour_t* pixels, float* depth, const int first, const int count,
+		const float u, const float du, const float v, const float dv, const float w, const float dw,
+		const Texture& texture, uint64_t& pixelsWritten);
+	template <RasterFill Fill, RasterDepth Depth, bool AlphaTest>
+	void rasterTexturedBlocks(colour_t* pixels, float* depth, const int first, const int count,
+		const float u, const float du, const float v, const float dv, const float w, const float dw,
+		const Texture& texture, uint64_t& pixelsWritten);
+	void addRasterCounts(const RasterStats& counts);
+	std::vector<uint8> vOverdraw;	///< Pixels covered since clearDepthBuffer
+	RenderQueue renderQueue;		///< Orders objects of rasterTexturedTriangles
+
+	/**
+	 * \brief Mesh vertex transformed for the instance being drawn, so that
+	 * corners shared by several triangles are transformed once.
+	 */
+	struct RasterVertex
+	{
+		Vec4f world;		///< Model to world
+		Vec4f camera;		///< World to camera, if RASTER_VERTEX_CAMERA
+		Vec4f screen;		///< Projected to pixels, if RASTER_VERTEX_SCREEN
+		float w = 0.0f;		///< Clip space w of screen
+		uint stamp = 0;		///< vertexStamp it was transformed for
+		uint8 stages = 0;	///< RASTER_VERTEX_* flags
+	};
+	std::vector<RasterVertex> vVertexCache;	///< Post-transform cache, by vertex
+											///< index of the mesh being drawn
+	uint vertexStamp = 0;					///< Changed for every instance drawn
+	const float projectToScreen(const Matrix4x4& projectionMatrix, const Vec4f& p, Vec4f& screen) const;
+
+	std::vector<float> vTileDepth;	///< Bound on the farthest depth (1/w) of
+									///< each RASTER_BLOCK_SIZE tile (see 
+									///< RasterOptions::depthBounds)
+	int depthTilesX() const { return (width + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE; }
+	int depthTilesY() const { return (height + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE; }
+
+	/**
+	 * \brief Outline of a triangle drawn over the tiled targets once they
+	 * are resolved.
+	 */
+	struct RasterOutline
+	{
+		Vec2 v[3];			///< Corners in pixels
+		colour_t colour;	///< Colour of outline
+	};
+
+	// Tiled render targets (see RasterOptions::tiledTargets)
+	bool rasterTiled = false;			///< 3D triangles are drawn to vTiledColour
+										///< and vTiledDepth, set by clearDepthBuffer
+	std::vector<colour_t> vTiledColour;	///< Colour in RASTER_BLOCK_SIZE tiles
+	std::vector<float> vTiledDepth;		///< Depth (1/w), tiled as vTiledColour
+	std::vector<RasterOutline> vOutlines;	///< Wireframe drawn by resolveRasterTargets
+
+	std::vector<uint8> vTileFlags;		///< RASTER_TILE_* flags of each tile, only
+										///< used with tiled targets or fast clears
+	void prepareTile(const int tx, const int ty, const uint8 flags);
+
+	// HUD text retained between frames
+	TextLayout layoutFPS;
+	TextLayout layoutPos[5];
 };
@@ -0,0 +1,367 @@
+#include "graphics_blit.h"
+#include <cstdint>
+#include <cstring>
+
+#define BLIT_ALPHA_MASK (0xFF000000u)	///< Alpha channel of colour_t
+
+#ifdef BLIT_SSE2
+	#include <emmintrin.h>
+#endif
+#ifdef BLIT_AVX2
+	#include <immintrin.h>
+#endif
+
+/**
+ * \brief Returns x / 255 rounded to nearest, for x in [0, 255 * 255].
+ */
+static inline uint div255(const uint x)
+{
+	const uint t = x + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+/**
+ * \brief Converts straight alpha ARGB pixels (as loaded from a 32-bit .bmp) 
+ * to premultiplied alpha, in place.
+ * 
+ * \param pixels Pixels to convert
+ * \param count Number of pixels
+ */
+void premultiplyAlpha(colour_t* pixels, const size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const colour_t c = pixels[i];
+		const uint a = c >> 24;
+		const uint r = div255(((c >> 16) & 0xff) * a);
+		const uint g = div255(((c >> 8) & 0xff) * a);
+		const uint b = div255((c & 0xff) * a);
+		pixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+	}
+}
+
+/**
+ * \brief Copies a row of pixels.
+ */
+void blitCopyRow(colour_t* dst, const colour_t* src, const int count)
+{
+	memcpy(dst, src, sizeof(colour_t) * count);
+}
+
+/**
+ * \brief Blends one premultiplied pixel over another.
+ */
+static inline colour_t blendPixel(const colour_t dst, const colour_t src)
+{
+	const uint a = src >> 24;
+	if (a == 0xff)
+	{
+		return src;
+	}
+
+	const uint k = 255 - a;
+	const uint rb = div255(((dst >> 16) & 0xff) * k) << 16 | div255((dst & 0xff) * k);
+	const uint ag = div255((dst >> 24) * k) << 24 | div255(((dst >> 8) & 0xff) * k) << 8;
+	return src + (rb | ag);
+}
+
+#ifdef BLIT_SSE2
+/**
+ * \brief Blends 4 premultiplied pixels over dst: dst * (255 - a) / 255 + src.
+ */
+static inline __m128i blend4(const __m128i d, const __m128i s)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c128 = _mm_set1_epi16(128);
+	const __m128i c255 = _mm_set1_epi16(255);
+
+	// Broadcast alpha of each pixel to its 4 channels as 255 - a
+	__m128i sLo = _mm_unpacklo_epi8(s, zero);
+	__m128i sHi = _mm_unpackhi_epi8(s, zero);
+	__m128i kLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m128i kHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	kLo = _mm_sub_epi16(c255, kLo);
+	kHi = _mm_sub_epi16(c255, kHi);
+
+	__m128i tLo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), kLo), c128);
+	__m128i tHi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), kHi), c128);
+	tLo = _mm_srli_epi16(_mm_add_epi16(tLo, _mm_srli_epi16(tLo, 8)), 8);
+	tHi = _mm_srli_epi16(_mm_add_epi16(tHi, _mm_srli_epi16(tHi, 8)), 8);
+
+	return _mm_add_epi8(_mm_packus_epi16(tLo, tHi), s);
+}
+#endif
+
+#ifdef BLIT_AVX2
+/**
+ * \brief Blends 8 premultiplied pixels over dst, as blend4.
+ */
+static inline __m256i blend8(const __m256i d, const __m256i s)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c128 = _mm256_set1_epi16(128);
+	const __m256i c255 = _mm256_set1_epi16(255);
+
+	__m256i sLo = _mm256_unpacklo_epi8(s, zero);
+	__m256i sHi = _mm256_unpackhi_epi8(s, zero);
+	__m256i kLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m256i kHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	kLo = _mm256_sub_epi16(c255, kLo);
+	kHi = _mm256_sub_epi16(c255, kHi);
+
+	__m256i tLo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), kLo), c128);
+	__m256i tHi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), kHi), c128);
+	tLo = _mm256_srli_epi16(_mm256_add_epi16(tLo, _mm256_srli_epi16(tLo, 8)), 8);
+	tHi = _mm256_srli_epi16(_mm256_add_epi16(tHi, _mm256_srli_epi16(tHi, 8)), 8);
+
+	return _mm256_add_epi8(_mm256_packus_epi16(tLo, tHi), s);
+}
+#endif
+
+/**
+ * \brief Blends a row of premultiplied pixels over dst.
+ * 
+ * Groups of pixels which are fully transparent are skipped and groups 
+ * which are fully opaque are copied, so large transparent or solid areas
+ * of an overlay cost little more than a read of the source.
+ */
+void blitBlendRow(colour_t* dst, const colour_t* src, const int count)
+{
+	int i = 0;
+
+#if defined(BLIT_AVX2)
+	const __m256i alphaMask8 = _mm256_set1_epi32((int)BLIT_ALPHA_MASK);
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		const __m256i a = _mm256_and_si256(s, alphaMask8);
+		const int opaque = _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, alphaMask8));
+		if (_mm256_testz_si256(a, a))
+		{
+			continue;  // fully transparent
+		}
+		if (opaque == -1)
+		{
+			_mm256_storeu_si256((__m256i*)(dst + i), s);
+			continue;
+		}
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+		_mm256_storeu_si256((__m256i*)(dst + i), blend8(d, s));
+	}
+#endif
+
+#if defined(BLIT_SSE2)
+	const __m128i alphaMask4 = _mm_set1_epi32((int)BLIT_ALPHA_MASK);
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i a = _mm_and_si128(s, alphaMask4);
+		const int transparent = _mm_movemask_epi8(_mm_cmpeq_epi32(a, _mm_setzero_si128()));
+		const int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(a, alphaMask4));
+		if (transparent == 0xffff)
+		{
+			continue;
+		}
+		if (opaque == 0xffff)
+		{
+			_mm_storeu_si128((__m128i*)(dst + i), s);
+			continue;
+		}
+		const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+		_mm_storeu_si128((__m128i*)(dst + i), blend4(d, s));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		if ((src[i] & BLIT_ALPHA_MASK) != 0)
+		{
+			dst[i] = blendPixel(dst[i], src[i]);
+		}
+	}
+}
+
+/**
+ * \brief Copies or blends a rectangle of pixels. The rectangle must 
+ * already be clipped to both buffers.
+ * 
+ * \param dst First destination pixel
+ * \param dstStride Pixels between rows of dst
+ * \param src First source pixel
+ * \param srcStride Pixels between rows of src
+ * \param w Width of rectangle in pixels
+ * \param h Height of rectangle in pixels
+ * \param mode How source pixels are combined with dst
+ */
+void blitRect(colour_t* dst, const int dstStride, const colour_t* src, const int srcStride,
+	const int w, const int h, const BlitMode mode)
+{
+	if (w <= 0 || h <= 0)
+	{
+		return;
+	}
+
+	for (int y = 0; y < h; y++)
+	{
+		switch (mode)
+		{
+		case BlitMode::Copy:
+			blitCopyRow(dst, src, w);
+			break;
+		case BlitMode::Blend:
+			blitBlendRow(dst, src, w);
+			break;
+		}
+		dst += dstStride;
+		src += srcStride;
+	}
+}
+
+/**
+ * \brief Sets count 32-bit values to value with non-temporal stores, which
+ * go to memory without first reading each cache line in.
+ *
+ * For clearing whole buffers every frame, which at large sizes (4K) do not
+ * fit in cache anyway and are filled about twice as fast. Buffers smaller
+ * than BLIT_STREAM_MIN_BYTES are filled with fillRow instead, so they stay
+ * cached for the frame drawn over them.
+ *
+ * \param dst Values to set (4 byte aligned)
+ * \param value Value to set them to
+ * \param count Number of values
+ */
+void fillStream(uint* dst, const uint value, const size_t count)
+{
+	size_t i = 0;
+
+#if defined(BLIT_SSE2)
+	if (count * sizeof(uint) < BLIT_STREAM_MIN_BYTES)
+	{
+		fillRow((colour_t*)dst, value, (int)count);
+		return;
+	}
+
+	// Stores must be 16 byte aligned
+	for (; i < count && ((uintptr_t)(dst + i) & 15) != 0; i++)
+	{
+		dst[i] = value;
+	}
+
+	const __m128i c4 = _mm_set1_epi32((int)value);
+	for (; i + 16 <= count; i += 16)
+	{
+		_mm_stream_si128((__m128i*)(dst + i), c4);
+		_mm_stream_si128((__m128i*)(dst + i + 4), c4);
+		_mm_stream_si128((__m128i*)(dst + i + 8), c4);
+		_mm_stream_si128((__m128i*)(dst + i + 12), c4);
+	}
+	_mm_sfence();
+#endif
+
+	for (; i < count; i++)
+	{
+		dst[i] = value;
+	}
+}
+
+/**
+ * \brief Copies a w by h (at most BLIT_TILE_SIZE) rectangle of pixels
+ * between row strides, a whole tile at a time with SSE2.
+ */
+static inline void copyTile(colour_t* dst, const size_t dstStride, const colour_t* src, const size_t srcStride,
+	const int w, const int h)
+{
+#ifdef BLIT_SSE2
+	if (w == BLIT_TILE_SIZE && h == BLIT_TILE_SIZE)
+	{
+		for (int y = 0; y < BLIT_TILE_SIZE; y++, dst += dstStride, src += srcStride)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)src);
+			const __m128i b = _mm_loadu_si128((const __m128i*)(src + 4));
+			_mm_storeu_si128((__m128i*)dst, a);
+			_mm_storeu_si128((__m128i*)(dst + 4), b);
+		}
+		return;
+	}
+#endif
+
+	for (int y = 0; y < h; y++, dst += dstStride, src += srcStride)
+	{
+		memcpy(dst, src, sizeof(colour_t) * w);
+	}
+}
+
+/**
+ * \brief Copies a rectangle of pixels into tiled layout.
+ *
+ * Tiled buffers hold BLIT_TILE_SIZE square tiles one after another, left to
+ * right then bottom to top, each stored row by row. Vertical neighbours are
+ * BLIT_TILE_SIZE pixels apart instead of a whole row. Tiles on the right and
+ * top edges are padded, their pixels outside w by h are not written.
+ *
+ * \param tiles Tiled buffer of ceil(w / BLIT_TILE_SIZE) by 
+ * ceil(h / BLIT_TILE_SIZE) tiles
+ * \param src First pixel of source rectangle
+ * \param srcStride Pixels between rows of src
+ * \param w Width in pixels
+ * \param h Height in pixels
+ */
+void tileRect(colour_t* tiles, const colour_t* src, const int srcStride, const int w, const int h)
+{
+	for (int y = 0; y < h; y += BLIT_TILE_SIZE)
+	{
+		const int th = h - y < BLIT_TILE_SIZE ? h - y : BLIT_TILE_SIZE;
+		for (int x = 0; x < w; x += BLIT_TILE_SIZE, tiles += BLIT_TILE_PIXELS)
+		{
+			const int tw = w - x < BLIT_TILE_SIZE ? w - x : BLIT_TILE_SIZE;
+			copyTile(tiles, BLIT_TILE_SIZE, src + (size_t)y * srcStride + x, srcStride, tw, th);
+		}
+	}
+}
+
+/**
+ * \brief Copies a tiled buffer back to a rectangle of row-major pixels.
+ * 
+ * \see tileRect
+ */
+void untileRect(colour_t* dst, const int dstStride, const colour_t* tiles, const int w, const int h)
+{
+	for (int y = 0; y < h; y += BLIT_TILE_SIZE)
+	{
+		const int th = h - y < BLIT_TILE_SIZE ? h - y : BLIT_TILE_SIZE;
+		for (int x = 0; x < w; x += BLIT_TILE_SIZE, tiles += BLIT_TILE_PIXELS)
+		{
+			const int tw = w - x < BLIT_TILE_SIZE ? w - x : BLIT_TILE_SIZE;
+			copyTile(dst + (size_t)y * dstStride + x, dstStride, tiles, BLIT_TILE_SIZE, tw, th);
+		}
+	}
+}
+
+/**
+ * \brief Sets a row of pixels to one colour.
+ */
+void fillRow(colour_t* dst, const colour_t colour, const int count)
+{
+	int i = 0;
+
+#if defined(BLIT_AVX2)
+	const __m256i c8 = _mm256_set1_epi32((int)colour);
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_si256((__m256i*)(dst + i), c8);
+	}
+#endif
+
+#if defined(BLIT_SSE2)
+	const __m128i c4 = _mm_set1_epi32((int)colour);
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_si128((__m128i*)(dst + i), c4);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		dst[i] = colour;
+	}
+}
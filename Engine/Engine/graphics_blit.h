@@ -0,0 +1,44 @@
+/*****************************************************************//**
+ * \file   graphics_blit.h
+ * \brief  Contains functions for copying, alpha blending and filling
+ * rows of pixels, with SSE2/AVX2 kernels where available
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BLIT_SSE2	///< Blend 4 pixels per instruction
+#endif
+#if defined(__AVX2__)
+	#define BLIT_AVX2	///< Blend 8 pixels per instruction
+#endif
+
+#define BLIT_TILE_SIZE			(8)			///< Width and height of tiles of tiled buffers
+#define BLIT_TILE_PIXELS		(BLIT_TILE_SIZE * BLIT_TILE_SIZE)
+#define BLIT_STREAM_MIN_BYTES	(16 << 20)	///< Smallest fillStream which bypasses
+											///< the cache (about the size of a 
+											///< last level cache)
+
+/**
+ * \brief How source pixels are combined with the destination.
+ */
+enum class BlitMode
+{
+	Copy,		///< Source replaces destination
+	Blend,		///< Source is premultiplied ARGB, blended over destination
+};
+
+extern void premultiplyAlpha(colour_t* pixels, const size_t count);
+extern void blitCopyRow(colour_t* dst, const colour_t* src, const int count);
+extern void blitBlendRow(colour_t* dst, const colour_t* src, const int count);
+extern void blitRect(colour_t* dst, const int dstStride, const colour_t* src, const int srcStride,
+	const int w, const int h, const BlitMode mode);
+extern void fillStream(uint* dst, const uint value, const size_t count);
+extern void tileRect(colour_t* tiles, const colour_t* src, const int srcStride, const int w, const int h);
+extern void untileRect(colour_t* dst, const int dstStride, const colour_t* tiles, const int w, const int h);
+extern void fillRow(colour_t* dst, const colour_t colour, const int count);
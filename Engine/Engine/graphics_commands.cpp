@@ -0,0 +1,300 @@
+#include "graphics_commands.h"
+#include "graphics_objects.h"
+#include "graphics_renderqueue.h"
+#include "graphics_texture.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cassert>
+
+/**
+ * \brief Removes every command and payload, keeping their capacity.
+ */
+void RenderCommandBuffer::reset()
+{
+	vCommands.clear();
+	vClears.clear();
+	vMeshes.clear();
+	vRects.clear();
+	vTexts.clear();
+	sText.clear();
+	vSprites.clear();
+	vViews.clear();
+	vMaterials.clear();
+	layer = RenderLayer::Scene;
+}
+
+/**
+ * \brief Adds a command to the end of the buffer.
+ *
+ * \param index Index of its payload
+ * \param material Material key (meshes only)
+ * \param depth Depth key (meshes only)
+ */
+void RenderCommandBuffer::push(const RenderCommandType type, const uint index, const RenderLayer layer,
+	const uint material, const uint depth)
+{
+	RenderCommand c;
+	c.key = ((uint64_t)layer << RENDER_KEY_LAYER_SHIFT)
+		| ((uint64_t)(material & 0xffff) << RENDER_KEY_MATERIAL_SHIFT)
+		| ((uint64_t)(depth & 0xffff) << RENDER_KEY_DEPTH_SHIFT)
+		| (vCommands.size() & RENDER_KEY_SEQUENCE_MASK);
+	c.type = type;
+	c.index = index;
+	vCommands.push_back(c);
+}
+
+/**
+ * \brief Returns the material key of an instance: 0 without a texture,
+ * otherwise the texture's id with RENDER_MATERIAL_ALPHA set for RGBA.
+ */
+const uint RenderCommandBuffer::materialOf(const MeshInstance* instance)
+{
+	const Texture* texture = instance->pTexture;
+	if (texture == nullptr)
+	{
+		return 0;
+	}
+
+	uint id = 0;
+	while (id < vMaterials.size() && vMaterials[id] != texture)
+	{
+		id++;
+	}
+	if (id == vMaterials.size())
+	{
+		vMaterials.push_back(texture);
+	}
+
+	return (id + 1) | (texture->textureType == TextureType::RGBA ? RENDER_MATERIAL_ALPHA : 0);
+}
+
+/**
+ * \brief Sets the camera of meshes recorded after this call.
+ *
+ * \see Graphics::rasterTexturedTriangles
+ */
+void RenderCommandBuffer::setView(const Matrix4x4& projectionMatrix, const Matrix4x4& matrixCamera,
+	const Vec4f& vCamera, const Vec4f& vLookDir, const float maxObjectHitDistance)
+{
+	RenderView view;
+	view.projectionMatrix = projectionMatrix;
+	view.matrixCamera = matrixCamera;
+	view.vCamera = vCamera;
+	view.vLookDir = vLookDir;
+	view.maxObjectHitDistance = maxObjectHitDistance;
+	vViews.push_back(view);
+}
+
+/**
+ * \brief Records Graphics::clearScreen.
+ */
+void RenderCommandBuffer::clear(const colour_t colour)
+{
+	push(RenderCommandType::Clear, (uint)vClears.size(), layer);
+	vClears.push_back(colour);
+}
+
+/**
+ * \brief Records Graphics::clearDepthBuffer.
+ */
+void RenderCommandBuffer::clearDepth()
+{
+	push(RenderCommandType::ClearDepth, 0, layer);
+}
+
+/**
+ * \brief Records an instance to be drawn from the last view set.
+ *
+ * \note setView must have been called first.
+ */
+void RenderCommandBuffer::drawMesh(MeshInstance* instance)
+{
+	assert(instance != nullptr && !vViews.empty());
+
+	const RenderView& view = vViews.back();
+	const Vec4f vRay = instance->matrixWorldPos * Vec4f(0.0f, 0.0f, 0.0f) - view.vCamera;
+
+	push(RenderCommandType::Mesh, (uint)vMeshes.size(), layer,
+		materialOf(instance), renderDepthKey(Vec4f::DotProduct(vRay, vRay)));
+	vMeshes.push_back({ instance, (uint)vViews.size() - 1 });
+}
+
+/**
+ * \brief Records Graphics::drawRect.
+ */
+void RenderCommandBuffer::drawRect(const Vec2f& vf1, const Vec2f& vf2, const colour_t colour)
+{
+	push(RenderCommandType::Rect, (uint)vRects.size(), layer);
+	vRects.push_back({ vf1, vf2, colour });
+}
+
+/**
+ * \brief Records Graphics::drawText. str is copied.
+ */
+void RenderCommandBuffer::drawText(const std::string& str, const Vec2 v, const colour_t colour)
+{
+	push(RenderCommandType::Text, (uint)vTexts.size(), layer);
+	vTexts.push_back({ v, colour, (uint)sText.size(), (uint)str.size() });
+	sText += str;
+}
+
+/**
+ * \brief Records Graphics::Sprite::draw.
+ */
+void RenderCommandBuffer::drawSprite(Graphics::Sprite* sprite)
+{
+	push(RenderCommandType::Sprite, (uint)vSprites.size(), layer);
+	vSprites.push_back(sprite);
+}
+
+/**
+ * \brief Records every sprite of gfx.
+ *
+ * \see Graphics::drawSprites
+ */
+void RenderCommandBuffer::drawSprites(const Graphics& gfx)
+{
+	for (auto s : gfx.sprites)
+	{
+		drawSprite(s);
+	}
+}
+
+/**
+ * \brief Adds every command of other after the commands of this buffer, in
+ * other's current order.
+ *
+ * Lets several threads record into buffers of their own, which are then
+ * merged and sorted into one.
+ */
+void RenderCommandBuffer::append(const RenderCommandBuffer& other)
+{
+	const uint viewOffset = (uint)vViews.size();
+	vViews.insert(vViews.end(), other.vViews.begin(), other.vViews.end());
+
+	for (auto& c : other.vCommands)
+	{
+		const RenderLayer cLayer = (RenderLayer)(c.key >> RENDER_KEY_LAYER_SHIFT);
+		switch (c.type)
+		{
+		case RenderCommandType::Clear:
+		{
+			push(c.type, (uint)vClears.size(), cLayer);
+			vClears.push_back(other.vClears[c.index]);
+		} break;
+		case RenderCommandType::ClearDepth:
+		{
+			push(c.type, 0, cLayer);
+		} break;
+		case RenderCommandType::Mesh:
+		{
+			// Material ids are per buffer, depth is kept
+			const MeshPayload& mesh = other.vMeshes[c.index];
+			push(c.type, (uint)vMeshes.size(), cLayer, materialOf(mesh.instance),
+				(uint)(c.key >> RENDER_KEY_DEPTH_SHIFT) & 0xffff);
+			vMeshes.push_back({ mesh.instance, mesh.view + viewOffset });
+		} break;
+		case RenderCommandType::Rect:
+		{
+			push(c.type, (uint)vRects.size(), cLayer);
+			vRects.push_back(other.vRects[c.index]);
+		} break;
+		case RenderCommandType::Text:
+		{
+			TextPayload text = other.vTexts[c.index];
+			push(c.type, (uint)vTexts.size(), cLayer);
+			sText.append(other.sText, text.offset, text.length);
+			text.offset = (uint)sText.size() - text.length;
+			vTexts.push_back(text);
+		} break;
+		case RenderCommandType::Sprite:
+		{
+			push(c.type, (uint)vSprites.size(), cLayer);
+			vSprites.push_back(other.vSprites[c.index]);
+		} break;
+		}
+	}
+}
+
+/**
+ * \brief Orders commands by layer, then material, depth and record order.
+ *
+ * \see RenderCommandBuffer
+ */
+void RenderCommandBuffer::sort()
+{
+	PROFILE_SCOPE("Sort commands");
+	std::sort(vCommands.begin(), vCommands.end(),
+		[](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+}
+
+/**
+ * \brief Draws every command to gfx in the current order.
+ *
+ * \param objectHit Set to the nearest object looked at by any view
+ * \return Returns true if an object is looked at
+ */
+const bool RenderCommandBuffer::execute(Graphics& gfx, ObjectHit& objectHit)
+{
+	PROFILE_SCOPE("Execute commands");
+
+	bool isHit = false;
+	const size_t n = vCommands.size();
+	size_t i = 0;
+	while (i < n)
+	{
+		const RenderCommand& c = vCommands[i];
+		switch (c.type)
+		{
+		case RenderCommandType::Clear:
+		{
+			gfx.clearScreen(vClears[c.index]);
+		} break;
+		case RenderCommandType::ClearDepth:
+		{
+			gfx.clearDepthBuffer();
+		} break;
+		case RenderCommandType::Mesh:
+		{
+			// Every following mesh of the same view is drawn in one call, in
+			// key order rather than re-sorted by the RenderQueue
+			const uint view = vMeshes[c.index].view;
+			vBatch.clear();
+			while (i < n && vCommands[i].type == RenderCommandType::Mesh && vMeshes[vCommands[i].index].view == view)
+			{
+				vBatch.push_back(vMeshes[vCommands[i].index].instance);
+				i++;
+			}
+
+			const RenderView& v = vViews[view];
+			ObjectHit hit;
+			if (gfx.rasterTexturedTriangles(v.projectionMatrix, v.matrixCamera, v.vCamera, v.vLookDir,
+				hit, v.maxObjectHitDistance, vBatch, nullptr, true))
+			{
+				if (!isHit || hit.fFistanceFromCamera < objectHit.fFistanceFromCamera)
+				{
+					objectHit = hit;
+				}
+				isHit = true;
+			}
+		} continue;  // i is past the batch
+		case RenderCommandType::Rect:
+		{
+			const RectPayload& rect = vRects[c.index];
+			gfx.drawRect(rect.vf1, rect.vf2, rect.colour);
+		} break;
+		case RenderCommandType::Text:
+		{
+			const TextPayload& text = vTexts[c.index];
+			gfx.drawGlyphRun(sText.data() + text.offset, text.length, text.v, text.colour);
+		} break;
+		case RenderCommandType::Sprite:
+		{
+			vSprites[c.index]->draw();
+		} break;
+		}
+		i++;
+	}
+
+	return isHit;
+}
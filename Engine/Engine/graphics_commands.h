@@ -0,0 +1,153 @@
+/*****************************************************************//**
+ * \file   graphics_commands.h
+ * \brief  Contains RenderCommandBuffer class to record draw calls, sort
+ * them and execute them on a Graphics later, possibly on another thread
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include "graphics.h"
+#include "utils_vector.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MeshInstance;
+class Texture;
+
+#define RENDER_KEY_LAYER_SHIFT		(56)	///< 8 bits of RenderLayer
+#define RENDER_KEY_MATERIAL_SHIFT	(40)	///< 16 bits of material
+#define RENDER_KEY_DEPTH_SHIFT		(24)	///< 16 bits of depth (see renderDepthKey)
+#define RENDER_KEY_SEQUENCE_MASK	(0xffffff)	///< 24 bits of record order
+#define RENDER_MATERIAL_ALPHA		(0x8000)	///< Material is alpha tested
+
+/**
+ * \brief Layers a frame is drawn in, lowest first.
+ */
+enum class RenderLayer : uint8
+{
+	Scene	= 0,	///< Clears and meshes
+	HUD		= 1,	///< Text, rects and sprites over the scene
+	Menu	= 2,	///< Menus over the HUD
+};
+
+/**
+ * \brief Kind of a RenderCommand, which selects its payload.
+ */
+enum class RenderCommandType : uint8
+{
+	Clear,		///< Graphics::clearScreen
+	ClearDepth,	///< Graphics::clearDepthBuffer
+	Mesh,		///< MeshInstance drawn with Graphics::rasterTexturedTriangles
+	Rect,		///< Graphics::drawRect
+	Text,		///< Graphics::drawText
+	Sprite,		///< Graphics::Sprite::draw
+};
+
+/**
+ * \brief Recorded draw call: its sort key and where its payload is.
+ */
+struct RenderCommand
+{
+	uint64_t key;			///< Layer, material, depth and record order
+	RenderCommandType type;
+	uint index;				///< Index into the payload vector of type
+};
+
+/**
+ * \brief Camera that meshes are drawn from.
+ */
+struct RenderView
+{
+	Matrix4x4 projectionMatrix;
+	Matrix4x4 matrixCamera;
+	Vec4f vCamera;
+	Vec4f vLookDir;
+	float maxObjectHitDistance = 0.0f;	///< Furthest object looked at
+};
+
+/**
+ * \brief Records draw calls into a linear buffer so that they can be
+ * reordered and executed after the caller is done with them.
+ *
+ * Each command is a 64-bit sort key and an index into a vector of payloads
+ * of its type; text is packed into one string. Keys are (high to low)
+ * layer, material, depth and record order, so sort() draws layers in
+ * order and, within a layer, every other command in the order recorded
+ * followed by meshes grouped by texture (alpha tested textures last) and
+ * front to back. Consecutive meshes of one view are drawn by a single
+ * Graphics::rasterTexturedTriangles in that order, so the buffer rather
+ * than RasterOptions::frontToBack decides the order of its meshes.
+ *
+ * A buffer is filled by one thread. Buffers recorded on several threads
+ * are merged with append(). execute() does not change what was recorded,
+ * so it can run on a render thread while the game thread records another
+ * buffer.
+ *
+ * \note Instances, sprites and the Graphics they were recorded with must
+ * stay alive and unchanged until execute() returns.
+ */
+class RenderCommandBuffer
+{
+private:
+	struct MeshPayload
+	{
+		MeshInstance* instance;
+		uint view;		///< Index into vViews
+	};
+
+	struct RectPayload
+	{
+		Vec2f vf1;
+		Vec2f vf2;
+		colour_t colour;
+	};
+
+	struct TextPayload
+	{
+		Vec2 v;
+		colour_t colour;
+		uint offset;	///< First character in sText
+		uint length;
+	};
+
+	std::vector<RenderCommand> vCommands;
+	std::vector<colour_t> vClears;
+	std::vector<MeshPayload> vMeshes;
+	std::vector<RectPayload> vRects;
+	std::vector<TextPayload> vTexts;
+	std::string sText;									///< Characters of every Text
+	std::vector<Graphics::Sprite*> vSprites;
+	std::vector<RenderView> vViews;
+	std::vector<const Texture*> vMaterials;				///< Textures by material id
+
+	RenderLayer layer = RenderLayer::Scene;				///< Layer of recorded commands
+	std::vector<MeshInstance*> vBatch;					///< Meshes drawn by one raster call
+
+	void push(const RenderCommandType type, const uint index, const RenderLayer layer, const uint material = 0,
+		const uint depth = 0);
+	const uint materialOf(const MeshInstance* instance);
+
+public:
+	void reset();
+	void setLayer(const RenderLayer layer) { this->layer = layer; }
+	void setView(const Matrix4x4& projectionMatrix, const Matrix4x4& matrixCamera,
+		const Vec4f& vCamera, const Vec4f& vLookDir, const float maxObjectHitDistance);
+
+	void clear(const colour_t colour);
+	void clearDepth();
+	void drawMesh(MeshInstance* instance);
+	void drawRect(const Vec2f& vf1, const Vec2f& vf2, const colour_t colour);
+	void drawText(const std::string& str, const Vec2 v, const colour_t colour);
+	void drawSprite(Graphics::Sprite* sprite);
+	void drawSprites(const Graphics& gfx);
+	void append(const RenderCommandBuffer& other);
+
+	void sort();
+	const bool execute(Graphics& gfx, ObjectHit& objectHit);
+
+	size_t size() const { return vCommands.size(); }
+};
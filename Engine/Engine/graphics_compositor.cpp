@@ -0,0 +1,464 @@
+#include "graphics_compositor.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * \brief Returns true if both elements draw the same pixels.
+ */
+const bool UIElement::operator==(const UIElement& e) const
+{
+	return type == e.type
+		&& v.x == e.v.x && v.y == e.v.y && w == e.w && h == e.h
+		&& colour == e.colour
+		&& pPixels == e.pPixels && mode == e.mode
+		&& text == e.text;
+}
+
+/**
+ * \param target Graphics the overlay is composited onto. The overlay
+ * follows its size.
+ */
+UICompositor::UICompositor(Graphics& target)
+	: target(target)
+{}
+
+/**
+ * \brief Starts recording the components of a new frame.
+ *
+ * \note Every begin() must be followed by composite() in the same frame.
+ */
+void UICompositor::begin()
+{
+	std::swap(vElements, vPrevElements);
+	numPrevElements = numElements;
+	numElements = 0;
+}
+
+/**
+ * \brief Redraws the whole overlay and target on the next composite.
+ */
+void UICompositor::invalidate()
+{
+	addDamage({ 0, 0, width, height });
+	targetStale = true;
+}
+
+/**
+ * \brief Returns a cleared element at the end of this frame's components.
+ *
+ * Elements are reused between frames so their text keeps its capacity.
+ */
+UIElement& UICompositor::push(const UIElement::Type type)
+{
+	if (numElements == vElements.size())
+	{
+		vElements.emplace_back();
+	}
+
+	UIElement& e = vElements[numElements++];
+	e.type = type;
+	e.v = { 0, 0 };
+	e.w = 0;
+	e.h = 0;
+	e.colour = 0;
+	e.pLayout = nullptr;
+	e.vRuns.clear();
+	e.text.clear();
+	e.pPixels = nullptr;
+	e.mode = BlitMode::Copy;
+	return e;
+}
+
+/**
+ * \brief Returns the pixels covered by e, clipped to the overlay.
+ */
+const PxRect UICompositor::bounds(const UIElement& e) const
+{
+	PxRect r = { e.v.x, e.v.y, e.v.x + e.w, e.v.y + e.h };
+	clamp(&r.x1, 0, width);
+	clamp(&r.x2, 0, width);
+	clamp(&r.y1, 0, height);
+	clamp(&r.y2, 0, height);
+	return r;
+}
+
+/**
+ * \brief Adds a rect to be redrawn, merging it with any damage it touches
+ * so vDamage stays disjoint.
+ */
+void UICompositor::addDamage(PxRect r)
+{
+	if (r.isEmpty())
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < vDamage.size(); )
+	{
+		const PxRect& d = vDamage[i];
+		if (r.x1 <= d.x2 && d.x1 <= r.x2 && r.y1 <= d.y2 && d.y1 <= r.y2)
+		{
+			r = { std::min(r.x1, d.x1), std::min(r.y1, d.y1), std::max(r.x2, d.x2), std::max(r.y2, d.y2) };
+			vDamage.erase(vDamage.begin() + i);
+			i = 0;  // grown rect may now touch earlier damage
+		}
+		else
+		{
+			i++;
+		}
+	}
+	vDamage.push_back(r);
+
+	if (vDamage.size() > UI_MAX_DAMAGE_RECTS)
+	{
+		PxRect u = vDamage[0];
+		for (auto& d : vDamage)
+		{
+			u = { std::min(u.x1, d.x1), std::min(u.y1, d.y1), std::max(u.x2, d.x2), std::max(u.y2, d.y2) };
+		}
+		vDamage.clear();
+		vDamage.push_back(u);
+	}
+}
+
+/**
+ * \brief Clears r in the overlay and draws every component of this frame
+ * clipped to it.
+ */
+void UICompositor::redraw(const PxRect& r)
+{
+	for (int y = r.y1; y < r.y2; y++)
+	{
+		memset(&vOverlay[r.x1 + y * width], 0, sizeof(colour_t) * (r.x2 - r.x1));
+	}
+
+	for (size_t i = 0; i < numElements; i++)
+	{
+		const UIElement& e = vElements[i];
+		PxRect c = bounds(e);
+		c = { std::max(c.x1, r.x1), std::max(c.y1, r.y1), std::min(c.x2, r.x2), std::min(c.y2, r.y2) };
+		if (c.isEmpty())
+		{
+			continue;
+		}
+
+		switch (e.type)
+		{
+		case UIElement::Type::Fill:
+		{
+			const colour_t colour = e.colour | UINT32_ALPHA_CHANNEL;
+			for (int y = c.y1; y < c.y2; y++)
+			{
+				std::fill_n(&vOverlay[c.x1 + y * width], c.x2 - c.x1, colour);
+			}
+		} break;
+		case UIElement::Type::Text:
+		{
+			const colour_t colour = e.colour | UINT32_ALPHA_CHANNEL;
+			for (auto& run : e.pLayout != nullptr ? e.pLayout->getRuns() : e.vRuns)
+			{
+				const int y = e.v.y + run.y;
+				if (y < c.y1 || y >= c.y2)
+				{
+					continue;
+				}
+
+				const int x1 = std::max(e.v.x + run.x, c.x1);
+				const int x2 = std::min(e.v.x + run.x + run.length, c.x2);
+				if (x1 < x2)
+				{
+					std::fill_n(&vOverlay[x1 + y * width], x2 - x1, colour);
+				}
+			}
+		} break;
+		case UIElement::Type::Image:
+		{
+			colour_t* dst = &vOverlay[c.x1 + c.y1 * width];
+			const colour_t* src = e.pPixels + (c.x1 - e.v.x) + (c.y1 - e.v.y) * e.w;
+			blitRect(dst, width, src, e.w, c.x2 - c.x1, c.y2 - c.y1, e.mode);
+
+			if (e.mode == BlitMode::Copy)
+			{
+				for (int y = c.y1; y < c.y2; y++)
+				{
+					colour_t* pixel = &vOverlay[c.x1 + y * width];
+					for (int x = c.x1; x < c.x2; x++)
+					{
+						*pixel++ |= UINT32_ALPHA_CHANNEL;
+					}
+				}
+			}
+		} break;
+		}
+	}
+}
+
+/**
+ * \brief Rebuilds the non-empty spans of rows y1 to y2 (exclusive).
+ */
+void UICompositor::updateSpans(const int y1, const int y2)
+{
+	for (int y = y1; y < y2; y++)
+	{
+		std::vector<OverlaySpan>& spans = vSpans[y];
+		spans.clear();
+
+		const colour_t* row = &vOverlay[y * width];
+		int x = 0;
+		while (x < width)
+		{
+			while (x < width && row[x] == 0)
+			{
+				x++;
+			}
+			if (x == width)
+			{
+				break;
+			}
+
+			const int start = x;
+			while (x < width && row[x] != 0)
+			{
+				x++;
+			}
+			spans.push_back({ start, x });
+		}
+	}
+}
+
+/**
+ * \brief Redraws damaged parts of the overlay and combines it with target.
+ *
+ * Damage is found by comparing this frame's components with the previous
+ * frame's, in the order they were drawn. When target changes size the
+ * overlay is reallocated and redrawn in full.
+ *
+ * \param mode How the overlay is combined with target
+ *
+ * \see CompositeMode
+ */
+void UICompositor::composite(const CompositeMode mode)
+{
+	if (target.width != width || target.height != height || target.sizeGeneration != sizeGeneration)
+	{
+		width = target.width;
+		height = target.height;
+		sizeGeneration = target.sizeGeneration;
+		vOverlay.assign((size_t)width * height, 0);
+		vSpans.assign(height, std::vector<OverlaySpan>());
+		vDamage.clear();
+		invalidate();
+	}
+
+	const size_t n = std::max(numElements, numPrevElements);
+	for (size_t i = 0; i < n; i++)
+	{
+		if (i < numElements && i < numPrevElements && vElements[i] == vPrevElements[i])
+		{
+			continue;
+		}
+		if (i < numPrevElements)
+		{
+			addDamage(bounds(vPrevElements[i]));
+		}
+		if (i < numElements)
+		{
+			addDamage(bounds(vElements[i]));
+		}
+	}
+
+	damagedPixels = 0;
+	for (auto& r : vDamage)
+	{
+		redraw(r);
+		updateSpans(r.y1, r.y2);
+		damagedPixels += (r.x2 - r.x1) * (r.y2 - r.y1);
+	}
+
+	colour_t* pixels = (colour_t*)target.pBuffer;
+	switch (mode)
+	{
+	case CompositeMode::Overlay:
+	{
+		for (int y = 0; y < height; y++)
+		{
+			for (auto& s : vSpans[y])
+			{
+				const int i = s.x1 + y * width;
+				blitBlendRow(pixels + i, &vOverlay[i], s.x2 - s.x1);
+			}
+		}
+		targetStale = true;
+	} break;
+	case CompositeMode::Exclusive:
+	{
+		if (targetStale)
+		{
+			blitCopyRow(pixels, vOverlay.data(), width * height);
+			targetStale = false;
+		}
+		else
+		{
+			for (auto& r : vDamage)
+			{
+				for (int y = r.y1; y < r.y2; y++)
+				{
+					const int i = r.x1 + y * width;
+					blitCopyRow(pixels + i, &vOverlay[i], r.x2 - r.x1);
+				}
+			}
+		}
+	} break;
+	}
+
+	vDamage.clear();
+}
+
+/**
+ * \brief Draws solid rectangle.
+ *
+ * \see Graphics::drawRect
+ */
+void UICompositor::drawRect(const Vec2f& vf1, const Vec2f& vf2, const colour_t colour)
+{
+	const Vec2 v1 = target.screenToPx(vf1);
+	const Vec2 v2 = target.screenToPx(vf2);
+
+	UIElement& e = push(UIElement::Type::Fill);
+	e.v = v1;
+	e.w = v2.x - v1.x;
+	e.h = v2.y - v1.y;
+	e.colour = colour;
+}
+
+/**
+ * \brief Draws a TextLayout, laying it out first if its content changed.
+ *
+ * \note layout must stay alive until composite(), unless copyText is set.
+ *
+ * \see Graphics::drawTextLayout
+ */
+void UICompositor::drawTextLayout(TextLayout& layout, const Vec2 v, const colour_t colour)
+{
+	layout.layout(*target.text2D);
+
+	UIElement& e = push(UIElement::Type::Text);
+	e.v = v;
+	e.w = layout.getWidth();
+	e.h = layout.getHeight();
+	e.colour = colour;
+	e.text = layout.getText();
+	if (copyText)
+	{
+		e.vRuns = layout.getRuns();
+	}
+	else
+	{
+		e.pLayout = &layout;
+	}
+}
+
+/**
+ * \brief Draws text of a GUIText in the colour of its state.
+ *
+ * \see Graphics::drawText
+ */
+void UICompositor::drawText(const GUIText& guiText)
+{
+	if (!target.layoutText(guiText))
+	{
+		return;
+	}
+
+	const colour_t colour = guiText.colourPallete[static_cast<int>(guiText.state)];
+	drawTextLayout(guiText.layout, target.screenToPx(guiText.vf1), colour);
+}
+
+/**
+ * \brief Draws GUIForm components.
+ *
+ * \see Graphics::drawGUIForm
+ */
+void UICompositor::drawGUIForm(GUIForm* guiForm)
+{
+	GUIRect* r = guiForm->getRect();
+	drawRect(r->vf1, r->vf2, r->colourPallete[static_cast<int>(r->state)]);
+	if (r->pGUITextInput != nullptr)
+	{
+		drawText(*r->pGUITextInput);
+	}
+}
+
+/**
+ * \brief Draws GUIMenu components.
+ *
+ * \see Graphics::drawGUIMenu
+ */
+void UICompositor::drawGUIMenu(GUIMenu* guiMenu)
+{
+	GUIRect* r = guiMenu->getRect();
+	drawRect(r->vf1, r->vf2, r->colourPallete[static_cast<int>(r->state)]);
+
+	for (auto t : guiMenu->getVText())
+	{
+		drawText(*t);
+	}
+}
+
+/**
+ * \brief Draws the current state of a GUISprite from its pre-scaled cache.
+ *
+ * \see Graphics::drawGUIMenuSprite
+ */
+void UICompositor::drawGUIMenuSprite(GUISprite* guiSprite)
+{
+	const Vec2 v1 = target.screenToPx(guiSprite->vf1);
+	const Vec2 v2 = target.screenToPx(guiSprite->vf2);
+	const int w = v2.x - v1.x;
+	const int h = v2.y - v1.y;
+
+	if (!guiSprite->isCacheValid(w, h, target.sizeGeneration))
+	{
+		guiSprite->updateCache(w, h, target.sizeGeneration);
+	}
+
+	UIElement& e = push(UIElement::Type::Image);
+	e.v = v1;
+	e.w = w;
+	e.h = h;
+	e.pPixels = guiSprite->getCachedState();
+	e.mode = guiSprite->Tex()->textureType == TextureType::RGBA ? BlitMode::Blend : BlitMode::Copy;
+}
+
+/**
+ * \brief Draws a sprite of target.
+ *
+ * \see Graphics::Sprite::draw
+ */
+void UICompositor::drawSprite(const Graphics::Sprite* sprite)
+{
+	if (sprite->pData == nullptr)
+	{
+		return;
+	}
+
+	UIElement& e = push(UIElement::Type::Image);
+	e.v = target.screenToPx(sprite->vf1);
+	e.w = sprite->dataWidth;
+	e.h = sprite->dataHeight;
+	e.pPixels = (const colour_t*)sprite->pData;
+	e.mode = sprite->pTexture->textureType == TextureType::RGBA ? BlitMode::Blend : BlitMode::Copy;
+}
+
+/**
+ * \brief Draws every sprite of target.
+ *
+ * \see Graphics::drawSprites
+ */
+void UICompositor::drawSprites()
+{
+	for (auto s : target.sprites)
+	{
+		drawSprite(s);
+	}
+}
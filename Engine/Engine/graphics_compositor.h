@@ -0,0 +1,142 @@
+/*****************************************************************//**
+ * \file   graphics_compositor.h
+ * \brief  Contains UICompositor class to draw GUI components into a
+ * retained overlay that is only redrawn where it changes
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include "graphics.h"
+#include "graphics_blit.h"
+#include "graphics_textlayout.h"
+#include "graphics_ui.h"
+#include <string>
+#include <vector>
+
+#define UI_MAX_DAMAGE_RECTS (16)	///< Damage is merged into one rect past this
+
+/**
+ * \brief How UICompositor::composite combines the overlay with its target.
+ */
+enum class CompositeMode
+{
+	Overlay,	///< Target is redrawn every frame, every non-empty span of the
+				///< overlay is blended over it
+	Exclusive,	///< Nothing else draws to target, only damaged rects of the
+				///< overlay are copied to it
+};
+
+/**
+ * \brief Rectangle of pixels where x2 and y2 are exclusive.
+ */
+struct PxRect
+{
+	int x1 = 0;
+	int y1 = 0;
+	int x2 = 0;
+	int y2 = 0;
+
+	const bool isEmpty() const { return x1 >= x2 || y1 >= y2; }
+};
+
+/**
+ * \brief Horizontal run of non-empty overlay pixels.
+ */
+struct OverlaySpan
+{
+	int x1;	///< First pixel of span
+	int x2;	///< One past the last pixel of span
+};
+
+/**
+ * \brief Component drawn to the overlay, as recorded for one frame.
+ */
+struct UIElement
+{
+	enum class Type
+	{
+		Fill,	///< Solid rectangle
+		Text,	///< Solid runs of a TextLayout
+		Image,	///< Pixels copied (opaque) or blended (premultiplied)
+	};
+
+	Type type = Type::Fill;
+	Vec2 v;									///< Bottom-left pixel
+	int w = 0;								///< Width in pixels
+	int h = 0;								///< Height in pixels
+	colour_t colour = 0;					///< Colour of Fill and Text
+	const TextLayout* pLayout = nullptr;	///< Runs of Text
+	std::vector<TextRun> vRuns;				///< Copy of the runs of Text when 
+											///< UICompositor::copyText is set
+	std::string text;						///< Content of pLayout when recorded
+	const colour_t* pPixels = nullptr;		///< Pixels of Image (row stride w)
+	BlitMode mode = BlitMode::Copy;			///< How Image is drawn
+
+	const bool operator==(const UIElement& e) const;
+};
+
+/**
+ * \brief Draws GUI components into a persistent overlay and composites it
+ * onto a Graphics target.
+ *
+ * Components are submitted every frame between begin() and composite(), in
+ * the same calls as the equivalent Graphics::draw functions. The overlay is
+ * only redrawn inside rects where a component was added, removed, moved or
+ * changed (state, text or colour) since the last frame. The non-empty spans
+ * of each overlay row are kept so that compositing skips empty space.
+ *
+ * \note Solid colours are made opaque in the overlay, images drawn with
+ * BlitMode::Copy are treated as opaque.
+ */
+class UICompositor
+{
+private:
+	Graphics& target;							///< Graphics composited onto
+	int width = 0;								///< Width of overlay
+	int height = 0;								///< Height of overlay
+	uint sizeGeneration = 0;					///< target size the overlay was made for
+	std::vector<colour_t> vOverlay;				///< Premultiplied pixels (0 = empty)
+	std::vector<std::vector<OverlaySpan>> vSpans;	///< Non-empty spans of each row
+
+	std::vector<UIElement> vElements;			///< Components of this frame
+	std::vector<UIElement> vPrevElements;		///< Components of the previous frame
+	size_t numElements = 0;						///< Used entries of vElements
+	size_t numPrevElements = 0;					///< Used entries of vPrevElements
+
+	std::vector<PxRect> vDamage;				///< Disjoint rects to be redrawn
+	bool targetStale = true;					///< target does not hold the overlay
+	int damagedPixels = 0;						///< Pixels redrawn by last composite
+
+	UIElement& push(const UIElement::Type type);
+	const PxRect bounds(const UIElement& e) const;
+	void addDamage(PxRect r);
+	void redraw(const PxRect& r);
+	void updateSpans(const int y1, const int y2);
+
+public:
+	explicit UICompositor(Graphics& target);
+	UICompositor(const UICompositor&) = delete;
+	UICompositor& operator=(const UICompositor&) = delete;
+
+	void begin();
+	void composite(const CompositeMode mode);
+	void invalidate();
+
+	void drawRect(const Vec2f& vf1, const Vec2f& vf2, const colour_t colour);
+	void drawTextLayout(TextLayout& layout, const Vec2 v, const colour_t colour);
+	void drawText(const GUIText& guiText);
+	void drawGUIForm(GUIForm* guiForm);
+	void drawGUIMenu(GUIMenu* guiMenu);
+	void drawGUIMenuSprite(GUISprite* guiSprite);
+	void drawSprite(const Graphics::Sprite* sprite);
+	void drawSprites();
+
+	int getDamagedPixels() const { return damagedPixels; }
+
+	bool copyText = false;	///< Text keeps a copy of the runs of its layout,
+							///< so the layout can change before composite()
+							///< (as when composited on another thread)
+};
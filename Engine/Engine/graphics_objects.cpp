@@ -1,16 +1,19 @@
 #include "utils.h"
 #include "graphics_objects.h"
-#include <fstream>
+#include "graphics_objloader.h"
 #include <iostream>
 
 /**
- * \brief Loads .obj file and loads data into vTris.
+ * \brief Loads .obj file as a single face, keeping its vertex indices.
+ * 
+ * Faces with more than three corners are split into triangles and normals
+ * are kept when the file has them (see ObjLoader).
  * 
  * \param filename Relative filename ending in .obj
- * \param hasTexture Determines how to interpret .obj data
+ * \param hasTexture Use the file's texture coords, which it must have
  * \return Returns true if successful, otherwise false
  */
-bool Object::LoadObjectFile(std::string filename, bool hasTexture)
+bool Mesh::LoadObjectFile(std::string filename, bool hasTexture)
 {
 	if (!stringEndsWith(filename, ".obj"))
 	{
@@ -20,104 +23,60 @@ bool Object::LoadObjectFile(std::string filename, bool hasTexture)
 		return false;
 	}
 
-	vTris.clear();
+	clear();
 
-	std::ifstream file(filename);
+	ObjLoader loader;
+	if (!loader.load(filename))
+	{
+		return false;
+	}
 
-	if (!file.is_open())
+	if (hasTexture && !loader.hasTexCoords())
 	{
 		std::cerr
 			<< "Error loading: " << filename
-			<< " -> File is already open\n";
+			<< " -> File has no texture coords\n";
 		return false;
 	}
 
-	std::vector<Vec4f> verticies;
-	std::vector<Vec3f> textures;
+	vVertices = std::move(loader.vPositions);
 
-	while (!file.eof())
+	const size_t corners = loader.vCorners.size();
+	vIndices.resize(corners);
+	vTexCoords.resize(corners);
+	if (loader.hasNormals())
 	{
-		// assuming line <= 128
-		char line[128];
-		file.getline(line, 128);
-
-		std::strstream s;
-		s << line;
-
-		char temp;  // hold junk
-
-		if (line[0] == 'v')
-		{
-			if (line[1] == 't' && line[2] == ' ')
-			{
-				Vec3f v;
-				s >> temp >> temp >> v.u >> v.v;
-				textures.push_back(v);
-			}
-			else if (line[1] == ' ')
-			{
-				Vec4f v;
-				s >> temp >> v.x >> v.y >> v.z;
-				verticies.push_back(v);
-			}
-		}
+		vNormals.resize(corners, Vec4f(0.0f, 0.0f, 0.0f, 0.0f));
+	}
 
-		if (!hasTexture)
+	for (size_t i = 0; i < corners; i++)
+	{
+		const ObjCorner& c = loader.vCorners[i];
+		vIndices[i] = (uint)c.v;
+		if (hasTexture && c.vt != OBJ_NO_INDEX)
 		{
-			if (line[0] == 'f' && line[1] == ' ')
-			{
-				int f[3];
-				s >> temp >> f[0] >> f[1] >> f[2];
-				vTris.push_back({ this, verticies[f[0] - 1], verticies[f[1] - 1], verticies[f[2] - 1] });
-			}
+			vTexCoords[i] = loader.vTexCoords[c.vt];
 		}
-		else
+		if (!vNormals.empty() && c.vn != OBJ_NO_INDEX)
 		{
-			// TODO throw exception if file doesnt actually contain texture shit
-			if (line[0] == 'f' && line[1] == ' ')
-			{
-				s >> temp;
-				std::string tokens[6];
-				int nTokenCount = -1;
-
-				while (!s.eof())
-				{
-					char c = s.get();
-					if (c == ' ' || c == '/')
-					{
-						nTokenCount++;
-					}
-					else
-					{
-						tokens[nTokenCount].append(1, c);
-					}
-				}
-
-				tokens[nTokenCount].pop_back();
-
-				vTris.push_back({ this, Vec4f(verticies[std::stoi(tokens[0]) - 1]), Vec4f(verticies[std::stoi(tokens[2]) - 1]), Vec4f(verticies[std::stoi(tokens[4]) - 1]), Vec3f(textures[std::stoi(tokens[1]) - 1]), Vec3f(textures[std::stoi(tokens[3]) - 1]), Vec3f(textures[std::stoi(tokens[5]) - 1]) });
-			}
+			vNormals[i] = loader.vNormals[c.vn];
 		}
 	}
 
+	vFaceEnd.push_back((uint)getTriangleCount());
 	return true;
 }
 
 /**
- * \brief Fills vTris with triangles manually.
+ * \brief Fills the mesh with the six faces of a unit cube manually, in the 
+ * order of ObjectFace. Its 36 corners share 8 vertices.
  */
-void Object::LoadTestCube(std::string objectName)
+void Mesh::LoadTestCube(std::string meshName)
 {
-	name = objectName;
+	name = meshName;
 
-	// South
-	vTris.clear();
-	for (auto f : faces)
-	{
-		f.vTris.clear();
-	}
-	faces.reserve(6);
-	Face front, back, left, right, top, bottom;
+	clear();
+	Triangle front[2], back[2], left[2], right[2], top[2], bottom[2];
 
 	/* Use these for simple cube textures */
 	//Vec3f(1.0f, 0.0f), Vec3f(1.0f, 1.0f), Vec3f(0.0f, 1.0f)
@@ -161,32 +120,81 @@ Vec3f(1.0f, 0.5f), Vec3f(1.0f, 0.75f), Vec3f(0.75f, 0.75f)
 #define CUBEMAP_BOTTOM2()\
 Vec3f(1.0f, 0.5f), Vec3f(0.75f, 0.75f), Vec3f(0.75f, 0.5f)
 
-	front.vTris.push_back(	{ this, Vec4f(0.0f, 0.0f, 0.0f), Vec4f(0.0f, 1.0f, 0.0f), Vec4f(1.0f, 1.0f, 0.0f), CUBEMAP_FRONT1() });
-	front.vTris.push_back(	{ this, Vec4f(0.0f, 0.0f, 0.0f), Vec4f(1.0f, 1.0f, 0.0f), Vec4f(1.0f, 0.0f, 0.0f), CUBEMAP_FRONT2() });
+	front[0] =	{ nullptr, Vec4f(0.0f, 0.0f, 0.0f), Vec4f(0.0f, 1.0f, 0.0f), Vec4f(1.0f, 1.0f, 0.0f), CUBEMAP_FRONT1() };
+	front[1] =	{ nullptr, Vec4f(0.0f, 0.0f, 0.0f), Vec4f(1.0f, 1.0f, 0.0f), Vec4f(1.0f, 0.0f, 0.0f), CUBEMAP_FRONT2() };
 
-	back.vTris.push_back(	{ this, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(1.0f, 1.0f, 1.0f), Vec4f(0.0f, 1.0f, 1.0f), CUBEMAP_BACK1() });
-	back.vTris.push_back(	{ this, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(0.0f, 1.0f, 1.0f), Vec4f(0.0f, 0.0f, 1.0f), CUBEMAP_BACK2() });
+	back[0] =	{ nullptr, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(1.0f, 1.0f, 1.0f), Vec4f(0.0f, 1.0f, 1.0f), CUBEMAP_BACK1() };
+	back[1] =	{ nullptr, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(0.0f, 1.0f, 1.0f), Vec4f(0.0f, 0.0f, 1.0f), CUBEMAP_BACK2() };
 
-	left.vTris.push_back(	{ this, Vec4f(1.0f, 0.0f, 0.0f), Vec4f(1.0f, 1.0f, 0.0f), Vec4f(1.0f, 1.0f, 1.0f), CUBEMAP_LEFT1() });
-	left.vTris.push_back(	{ this, Vec4f(1.0f, 0.0f, 0.0f), Vec4f(1.0f, 1.0f, 1.0f), Vec4f(1.0f, 0.0f, 1.0f), CUBEMAP_LEFT2() });
+	left[0] =	{ nullptr, Vec4f(1.0f, 0.0f, 0.0f), Vec4f(1.0f, 1.0f, 0.0f), Vec4f(1.0f, 1.0f, 1.0f), CUBEMAP_LEFT1() };
+	left[1] =	{ nullptr, Vec4f(1.0f, 0.0f, 0.0f), Vec4f(1.0f, 1.0f, 1.0f), Vec4f(1.0f, 0.0f, 1.0f), CUBEMAP_LEFT2() };
 																											  
-	right.vTris.push_back(	{ this, Vec4f(0.0f, 0.0f, 1.0f), Vec4f(0.0f, 1.0f, 1.0f), Vec4f(0.0f, 1.0f, 0.0f), CUBEMAP_RIGHT1() });
-	right.vTris.push_back(	{ this, Vec4f(0.0f, 0.0f, 1.0f), Vec4f(0.0f, 1.0f, 0.0f), Vec4f(0.0f, 0.0f, 0.0f), CUBEMAP_RIGHT2() });
+	right[0] =	{ nullptr, Vec4f(0.0f, 0.0f, 1.0f), Vec4f(0.0f, 1.0f, 1.0f), Vec4f(0.0f, 1.0f, 0.0f), CUBEMAP_RIGHT1() };
+	right[1] =	{ nullptr, Vec4f(0.0f, 0.0f, 1.0f), Vec4f(0.0f, 1.0f, 0.0f), Vec4f(0.0f, 0.0f, 0.0f), CUBEMAP_RIGHT2() };
 																											   
-	top.vTris.push_back(	{ this, Vec4f(0.0f, 1.0f, 0.0f), Vec4f(0.0f, 1.0f, 1.0f), Vec4f(1.0f, 1.0f, 1.0f), CUBEMAP_TOP1() });
-	top.vTris.push_back(	{ this, Vec4f(0.0f, 1.0f, 0.0f), Vec4f(1.0f, 1.0f, 1.0f), Vec4f(1.0f, 1.0f, 0.0f), CUBEMAP_TOP2() });
+	top[0] =	{ nullptr, Vec4f(0.0f, 1.0f, 0.0f), Vec4f(0.0f, 1.0f, 1.0f), Vec4f(1.0f, 1.0f, 1.0f), CUBEMAP_TOP1() };
+	top[1] =	{ nullptr, Vec4f(0.0f, 1.0f, 0.0f), Vec4f(1.0f, 1.0f, 1.0f), Vec4f(1.0f, 1.0f, 0.0f), CUBEMAP_TOP2() };
 																											  
-	bottom.vTris.push_back(	{ this, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(0.0f, 0.0f, 1.0f), Vec4f(0.0f, 0.0f, 0.0f), CUBEMAP_BOTTOM1() });
-	bottom.vTris.push_back(	{ this, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(0.0f, 0.0f, 0.0f), Vec4f(1.0f, 0.0f, 0.0f), CUBEMAP_BOTTOM2() });
+	bottom[0] =	{ nullptr, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(0.0f, 0.0f, 1.0f), Vec4f(0.0f, 0.0f, 0.0f), CUBEMAP_BOTTOM1() };
+	bottom[1] =	{ nullptr, Vec4f(1.0f, 0.0f, 1.0f), Vec4f(0.0f, 0.0f, 0.0f), Vec4f(1.0f, 0.0f, 0.0f), CUBEMAP_BOTTOM2() };
 
 	/* Important! In order! */
-	faces.push_back(front);
-	faces.push_back(back);
-	faces.push_back(left);
-	faces.push_back(right);
-	faces.push_back(top);
-	faces.push_back(bottom);
+	addFace(front, 2);
+	addFace(back, 2);
+	addFace(left, 2);
+	addFace(right, 2);
+	addFace(top, 2);
+	addFace(bottom, 2);
+
+}
+
+/**
+ * \brief Adds a face made of count triangles after the last face.
+ * 
+ * Corners at the position of an existing vertex share it.
+ */
+void Mesh::addFace(const Triangle* triangles, const size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			vIndices.push_back(addVertex(triangles[i].p[j]));
+			vTexCoords.push_back(triangles[i].t[j]);
+		}
+	}
+	vFaceEnd.push_back((uint)getTriangleCount());
+}
 
+/**
+ * \brief Removes every vertex, triangle and face.
+ */
+void Mesh::clear()
+{
+	vVertices.clear();
+	vIndices.clear();
+	vTexCoords.clear();
+	vNormals.clear();
+	vFaceEnd.clear();
+}
+
+/**
+ * \brief Returns the index of the vertex at v, adding it if there is none.
+ * 
+ * \note Searches every vertex, meant for small hand made meshes.
+ */
+uint Mesh::addVertex(const Vec4f& v)
+{
+	for (size_t i = 0; i < vVertices.size(); i++)
+	{
+		const Vec4f& u = vVertices[i];
+		if (u.x == v.x && u.y == v.y && u.z == v.z && u.w == v.w)
+		{
+			return (uint)i;
+		}
+	}
+	vVertices.push_back(v);
+	return (uint)vVertices.size() - 1;
 }
 
 /**
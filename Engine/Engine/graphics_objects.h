@@ -1,7 +1,7 @@
 /*****************************************************************//**
  * \file   graphics_objects.h
- * \brief  Contains Triangle struct & Object class to describe 
- * 3D objects in application.
+ * \brief  Contains Triangle struct, Mesh & MeshInstance classes and the 
+ * Object class to describe 3D objects in application.
  * 
  * \author Chris
  * \date   September 2020
@@ -12,18 +12,20 @@
 #include "types.h"
 #include "utils_vector.h"
 #include "graphics_texture.h"
+#include <string>
 #include <vector>
 #include <ostream>
 
-class Object;
+struct MeshInstance;
 
 /**
  * \brief Contains positional, texture and colour info.
  */
 struct Triangle
 {
-	const Object* parent = nullptr;	///< Pointer to parent.
-									///< Mainly used to get parent's texture
+	const MeshInstance* parent = nullptr;	///< Instance the triangle is drawn
+											///< for, set when transformed.
+											///< Mainly used to get its texture
 	Vec4f p[3];						///< Triangle coords as 4D vector
 	Vec3f t[3];						///< Texture coords as 3D vector
 	colour_t colour;				///< Triangle colour.
@@ -35,6 +37,10 @@ struct Triangle
 extern int TriangleClipAgainstPlane(Vec4f plane_p, Vec4f plane_n, Triangle& in_tri, Triangle& out_tri1, Triangle& out_tri2);
 
 
+/**
+ * \brief Bit of each face of a cube in MeshInstance::faceMask, in the order
+ * Mesh::LoadTestCube adds them.
+ */
 enum class ObjectFace : uint8
 {
 	Front	= 1 << 0, 
@@ -45,11 +51,58 @@ enum class ObjectFace : uint8
 	Bottom	= 1 << 5,
 };
 
+#define MESH_MAX_FACES	(32)	///< Faces an instance can show or hide
+#define MESH_ALL_FACES	(0xffffffffu)
 
-struct Face
+
+/**
+ * \brief Geometry shared by every instance drawn with it.
+ * 
+ * Positions are stored once in vVertices and triangles index them, so a 
+ * corner shared by several triangles is transformed once per instance (see
+ * Graphics::rasterTexturedTriangles). Texture coordinates belong to the 
+ * corners of each triangle, as a cube shares positions but not texture 
+ * coordinates between its faces. Triangles are stored face by face so 
+ * that each instance can choose which faces it draws (see 
+ * MeshInstance::faceMask).
+ */
+class Mesh
 {
-	std::vector<Triangle> vTris;
-	bool draw = false;
+public:
+	std::string name;
+	std::vector<Vec4f> vVertices;	///< Unique positions
+	std::vector<uint> vIndices;		///< Three vertices per triangle, in face order
+	std::vector<Vec3f> vTexCoords;	///< Three texture coords per triangle
+	std::vector<Vec4f> vNormals;	///< Three normals per triangle if loaded
+									///< with any, otherwise empty
+	std::vector<uint> vFaceEnd;		///< One past the last triangle of each face
+	colour_t colour = 0;			///< Colour of untextured triangles
+
+public:
+	/* Loading */
+	bool LoadObjectFile(std::string filename, bool hasTexture);
+	void LoadTestCube(std::string meshName);
+	void addFace(const Triangle* triangles, const size_t count);
+	void clear();
+
+	size_t getFaceCount() const { return vFaceEnd.size(); }
+	size_t getTriangleCount() const { return vIndices.size() / 3; }
+
+private:
+	uint addVertex(const Vec4f& v);
+};
+
+
+/**
+ * \brief Mesh placed in the world: a reference to its geometry plus the 
+ * transform and material it is drawn with.
+ */
+struct MeshInstance
+{
+	const Mesh* pMesh = nullptr;		///< Shared geometry (not owned)
+	Matrix4x4 matrixWorldPos;			///< Model to world transform
+	Texture* pTexture = nullptr;		///< Pointer to a texture (optional)
+	uint faceMask = MESH_ALL_FACES;		///< Bit i set draws face i of pMesh
 };
 
 
@@ -58,32 +111,24 @@ struct Face
  * 
  * \note This object does not require a texture
  */
-class Object
+class Object : public MeshInstance
 {
 public:
 	std::string name;
-	Matrix4x4 matrixWorldPos;		///< Contains info on object in world
-	std::vector<Triangle> vTris;	///< Contains vector of triangles that
-									///< compose the object.
-	Texture* pTexture = nullptr;	///< Pointer to a texture (optional)
 	Vec3f vPos;						///< Positional vector.
 									///< x: + left		/ - right
 									///< y: + upwards	/ - downwards
 									///< z: + forwards	/ - backwards
-	std::vector<Face> faces;
 	void resetFacesDrawable()
 	{
-		for (auto f : faces)
-		{
-			f.draw = false;
-		}
+		faceMask = 0;
+	}
+	void setFaceDrawable(const ObjectFace face)
+	{
+		faceMask |= (uint)face;
 	}
 
 public:
-	/* Loading */
-	bool LoadObjectFile(std::string filename, bool hasTexture);
-	void LoadTestCube(std::string objectName);
-
 	/* Updating */
 	void updatePosition(const float fTheta);
 	void setPos(float x, float y, float z);
@@ -103,8 +148,8 @@ public:
 
 struct ObjectHit
 {
-	Triangle* triangleHit = nullptr;
-	Object* objectHit = nullptr;
+	int triangleHit = -1;			///< Index of the mesh triangle hit
+	MeshInstance* objectHit = nullptr;
 	float fFistanceFromCamera;
 	Vec4f vPoint;
 	Vec4f vNormal;
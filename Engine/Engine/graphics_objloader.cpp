@@ -0,0 +1,406 @@
+#include "graphics_objloader.h"
+#include "utils_file.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+static inline bool isObjSpace(const char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline const char* skipObjSpace(const char* p, const char* end)
+{
+	while (p < end && isObjSpace(*p))
+	{
+		p++;
+	}
+	return p;
+}
+
+/**
+ * \brief Parses the float at p (after any spaces) and moves p past it.
+ */
+static inline bool parseObjFloat(const char*& p, const char* end, float& value)
+{
+	p = skipObjSpace(p, end);
+	if (p < end && *p == '+')
+	{
+		p++;  // not accepted by from_chars
+	}
+
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec == std::errc::result_out_of_range)
+	{
+		// Too small or large for a float, round the double
+		double d;
+		result = std::from_chars(p, end, d);
+		value = (float)d;
+	}
+	if (result.ec != std::errc())
+	{
+		return false;
+	}
+
+	p = result.ptr;
+	return true;
+}
+
+/**
+ * \brief Runs func(i) for every i below count, on count - 1 new threads and
+ * the calling thread.
+ */
+template <typename Func>
+static void runObjChunks(const size_t count, Func func)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(count - 1);
+	for (size_t i = 1; i < count; i++)
+	{
+		threads.emplace_back(func, i);
+	}
+	func(0);
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+}
+
+/**
+ * \brief Maps filename and parses it.
+ *
+ * \return Returns true if successful, otherwise false
+ */
+bool ObjLoader::load(const std::string& filename)
+{
+	clear();
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+
+	return parse(file.data(), file.size(), filename);
+}
+
+/**
+ * \brief Parses the text of an .obj file, replacing what was loaded.
+ *
+ * \param name Name of the file for error messages
+ * \return Returns true if successful, otherwise false and nothing is loaded
+ */
+bool ObjLoader::parse(const char* text, const size_t size, const std::string& name)
+{
+	clear();
+
+	// One chunk per thread, ending at line ends
+	size_t threads = threadCount != 0 ? threadCount : std::thread::hardware_concurrency();
+	threads = std::max(threads, (size_t)1);
+	const size_t chunkCount = std::max((size_t)1, std::min(threads, size / std::max(minChunkBytes, (size_t)1)));
+
+	std::vector<Chunk> vChunks(chunkCount);
+	const char* start = text;
+	const char* const textEnd = text + size;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		const char* last = textEnd;
+		if (i + 1 < chunkCount)
+		{
+			const char* target = std::max(start, text + size / chunkCount * (i + 1));
+			const char* eol = (const char*)std::memchr(target, '\n', (size_t)(textEnd - target));
+			last = eol != nullptr ? eol + 1 : textEnd;
+		}
+
+		vChunks[i].first = start;
+		vChunks[i].last = last;
+		start = last;
+	}
+
+	runObjChunks(chunkCount, [&](const size_t i) { parseChunk(vChunks[i]); });
+
+	size_t line = 0;
+	for (auto& chunk : vChunks)
+	{
+		if (!chunk.error.empty())
+		{
+			std::cerr
+				<< "Error loading: " << name
+				<< " -> Line " << line + chunk.errorLine << ": " << chunk.error << "\n";
+			return false;
+		}
+		line += chunk.lines;
+	}
+
+	// Each chunk's elements follow those of the chunks before it
+	std::vector<size_t> vPositionBase(chunkCount), vTexCoordBase(chunkCount), vNormalBase(chunkCount), vCornerBase(chunkCount);
+	size_t positions = 0, texCoords = 0, normals = 0, corners = 0;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		vPositionBase[i] = positions;
+		vTexCoordBase[i] = texCoords;
+		vNormalBase[i] = normals;
+		vCornerBase[i] = corners;
+		positions += vChunks[i].vPositions.size();
+		texCoords += vChunks[i].vTexCoords.size();
+		normals += vChunks[i].vNormals.size();
+		corners += vChunks[i].vCorners.size();
+	}
+
+	vPositions.resize(positions);
+	vTexCoords.resize(texCoords);
+	vNormals.resize(normals);
+	vCorners.resize(corners);
+
+	runObjChunks(chunkCount, [&](const size_t i)
+		{
+			resolveChunk(vChunks[i], vPositionBase[i], vTexCoordBase[i], vNormalBase[i], vCornerBase[i]);
+		});
+
+	for (auto& chunk : vChunks)
+	{
+		if (!chunk.error.empty())
+		{
+			std::cerr << "Error loading: " << name << " -> " << chunk.error << "\n";
+			clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * \brief Removes everything loaded, keeping the settings.
+ */
+void ObjLoader::clear()
+{
+	vPositions.clear();
+	vTexCoords.clear();
+	vNormals.clear();
+	vCorners.clear();
+}
+
+/**
+ * \brief Parses the lines of a chunk into its own vectors. Negative
+ * indices are resolved as far as the chunk can.
+ *
+ * Stops at the first error, see Chunk::error.
+ */
+void ObjLoader::parseChunk(Chunk& chunk)
+{
+	std::vector<FaceCorner> polygon;
+
+	const char* p = chunk.first;
+	while (p < chunk.last)
+	{
+		const char* eol = (const char*)std::memchr(p, '\n', (size_t)(chunk.last - p));
+		if (eol == nullptr)
+		{
+			eol = chunk.last;
+		}
+		const char* end = eol;
+		if (end > p && end[-1] == '\r')
+		{
+			end--;
+		}
+		chunk.lines++;
+
+		const char* s = skipObjSpace(p, end);
+		p = eol + 1;
+		if (end - s < 2)
+		{
+			continue;  // blank, or too short to be a statement
+		}
+
+		bool ok = true;
+		if (s[0] == 'v' && isObjSpace(s[1]))
+		{
+			Vec4f v;
+			s += 2;
+			ok = parseObjFloat(s, end, v.x) && parseObjFloat(s, end, v.y) && parseObjFloat(s, end, v.z);
+			chunk.vPositions.push_back(v);
+		}
+		else if (s[0] == 'v' && s[1] == 't' && end - s > 2 && isObjSpace(s[2]))
+		{
+			Vec3f t;
+			s += 3;
+			ok = parseObjFloat(s, end, t.u);
+			if (ok && skipObjSpace(s, end) < end)
+			{
+				ok = parseObjFloat(s, end, t.v);
+			}
+			chunk.vTexCoords.push_back(t);
+		}
+		else if (s[0] == 'v' && s[1] == 'n' && end - s > 2 && isObjSpace(s[2]))
+		{
+			Vec4f n(0.0f, 0.0f, 0.0f, 0.0f);
+			s += 3;
+			ok = parseObjFloat(s, end, n.x) && parseObjFloat(s, end, n.y) && parseObjFloat(s, end, n.z);
+			chunk.vNormals.push_back(n);
+		}
+		else if (s[0] == 'f' && isObjSpace(s[1]))
+		{
+			ok = parseFace(s + 2, end, chunk, polygon);
+			if (!ok && chunk.error.empty())
+			{
+				chunk.error = "Face is not written as v, v/vt, v//vn or v/vt/vn";
+			}
+		}
+
+		if (!ok)
+		{
+			if (chunk.error.empty())
+			{
+				chunk.error = "Could not read number";
+			}
+			chunk.errorLine = chunk.lines;
+			return;
+		}
+	}
+}
+
+/**
+ * \brief Parses the corners of a face and adds it as a fan of triangles.
+ *
+ * \param p First character after "f"
+ * \param polygon Scratch space for the corners
+ * \return Returns true if successful, otherwise false
+ */
+bool ObjLoader::parseFace(const char* p, const char* end, Chunk& chunk, std::vector<FaceCorner>& polygon)
+{
+	const size_t counts[3] = { chunk.vPositions.size(), chunk.vTexCoords.size(), chunk.vNormals.size() };
+
+	// Sets index to element's 0-based index, which for a negative index is
+	// relative to the start of the chunk
+	auto parseIndex = [&](const int element, int& index, uint8& relative)
+	{
+		int value;
+		const std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec != std::errc() || value == 0)
+		{
+			return false;
+		}
+		p = result.ptr;
+
+		if (value > 0)
+		{
+			index = value - 1;
+		}
+		else
+		{
+			index = (int)counts[element] + value;
+			relative |= (uint8)(1 << element);
+		}
+		return true;
+	};
+
+	polygon.clear();
+	for (;;)
+	{
+		p = skipObjSpace(p, end);
+		if (p == end)
+		{
+			break;
+		}
+
+		FaceCorner c;
+		if (!parseIndex(0, c.corner.v, c.relative))
+		{
+			return false;
+		}
+		if (p < end && *p == '/')
+		{
+			p++;
+			if (p < end && *p != '/' && !parseIndex(1, c.corner.vt, c.relative))
+			{
+				return false;
+			}
+			if (p < end && *p == '/')
+			{
+				p++;
+				if (!parseIndex(2, c.corner.vn, c.relative))
+				{
+					return false;
+				}
+			}
+		}
+		if (p < end && !isObjSpace(*p))
+		{
+			return false;
+		}
+
+		polygon.push_back(c);
+	}
+
+	if (polygon.size() < 3)
+	{
+		chunk.error = "Face has fewer than 3 corners";
+		return false;
+	}
+
+	auto addCorner = [&](const FaceCorner& c)
+	{
+		for (uint8 element = 0; element < 3; element++)
+		{
+			if (c.relative & (1 << element))
+			{
+				chunk.vRelative.push_back({ (uint)chunk.vCorners.size(), element });
+			}
+		}
+		chunk.vCorners.push_back(c.corner);
+	};
+
+	for (size_t i = 1; i + 1 < polygon.size(); i++)
+	{
+		addCorner(polygon[0]);
+		addCorner(polygon[i]);
+		addCorner(polygon[i + 1]);
+	}
+	return true;
+}
+
+/**
+ * \brief Adds the number of elements before chunk to its negative indices,
+ * checks every index and copies the chunk into the loader's vectors.
+ *
+ * \return Returns true if successful, otherwise false and sets Chunk::error
+ */
+bool ObjLoader::resolveChunk(Chunk& chunk, const size_t positionBase, const size_t texCoordBase,
+	const size_t normalBase, const size_t cornerBase)
+{
+	const size_t bases[3] = { positionBase, texCoordBase, normalBase };
+	for (auto& r : chunk.vRelative)
+	{
+		ObjCorner& c = chunk.vCorners[r.corner];
+		int& index = r.element == 0 ? c.v : (r.element == 1 ? c.vt : c.vn);
+		index += (int)bases[r.element];
+		if (index < 0)
+		{
+			chunk.error = "Face uses a negative index before the element it counts back from";
+			return false;
+		}
+	}
+
+	const int positions = (int)vPositions.size();
+	const int texCoords = (int)vTexCoords.size();
+	const int normals = (int)vNormals.size();
+	for (auto& c : chunk.vCorners)
+	{
+		if (c.v >= positions
+			|| (c.vt != OBJ_NO_INDEX && c.vt >= texCoords)
+			|| (c.vn != OBJ_NO_INDEX && c.vn >= normals))
+		{
+			chunk.error = "Face uses a vertex, texture coord or normal that does not exist";
+			return false;
+		}
+	}
+
+	std::copy(chunk.vPositions.begin(), chunk.vPositions.end(), vPositions.begin() + positionBase);
+	std::copy(chunk.vTexCoords.begin(), chunk.vTexCoords.end(), vTexCoords.begin() + texCoordBase);
+	std::copy(chunk.vNormals.begin(), chunk.vNormals.end(), vNormals.begin() + normalBase);
+	std::copy(chunk.vCorners.begin(), chunk.vCorners.end(), vCorners.begin() + cornerBase);
+	return true;
+}
@@ -0,0 +1,111 @@
+/*****************************************************************//**
+ * \file   graphics_objloader.h
+ * \brief  Contains ObjLoader class to parse Wavefront .obj files into
+ * indexed triangles, in parallel for large files
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include "utils_vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define OBJ_NO_INDEX		(-1)			///< Corner has no texture coord / normal
+#define OBJ_MIN_CHUNK_BYTES	(1 << 20)		///< Smallest part of a file given to a thread
+
+/**
+ * \brief Corner of a triangle: 0-based indices into ObjLoader's vPositions,
+ * vTexCoords and vNormals.
+ */
+struct ObjCorner
+{
+	int v = OBJ_NO_INDEX;
+	int vt = OBJ_NO_INDEX;
+	int vn = OBJ_NO_INDEX;
+};
+
+/**
+ * \brief Parses the geometry of a Wavefront .obj file.
+ *
+ * Reads v, vt, vn and f statements; anything else (groups, materials,
+ * smoothing) is skipped. Faces may have any number of corners written as
+ * v, v/vt, v//vn or v/vt/vn, and are split into a fan of triangles.
+ * Negative indices count back from the last element defined above them.
+ *
+ * The file is memory mapped and split at line ends into one chunk per
+ * thread. Each thread parses its chunk with std::from_chars, then once the
+ * number of elements in the chunks before it is known it resolves its
+ * negative indices, checks every index and copies its results into place.
+ *
+ * \see Mesh::LoadObjectFile
+ */
+class ObjLoader
+{
+public:
+	std::vector<Vec4f> vPositions;
+	std::vector<Vec3f> vTexCoords;
+	std::vector<Vec4f> vNormals;		///< w is 0
+	std::vector<ObjCorner> vCorners;	///< Three per triangle
+
+	uint threadCount = 0;						///< Threads to parse with, 0 for
+												///< one per hardware thread
+	size_t minChunkBytes = OBJ_MIN_CHUNK_BYTES;	///< Smallest chunk per thread
+
+public:
+	bool load(const std::string& filename);
+	bool parse(const char* text, const size_t size, const std::string& name);
+	void clear();
+
+	size_t getTriangleCount() const { return vCorners.size() / 3; }
+	bool hasTexCoords() const { return !vTexCoords.empty(); }
+	bool hasNormals() const { return !vNormals.empty(); }
+
+private:
+	/**
+	 * \brief Corner index which counted back from the end of its chunk and
+	 * still needs the number of elements before the chunk added.
+	 */
+	struct RelativeIndex
+	{
+		uint corner;		///< Index into Chunk::vCorners
+		uint8 element;		///< 0: v, 1: vt, 2: vn
+	};
+
+	/**
+	 * \brief Corner of a face being parsed.
+	 */
+	struct FaceCorner
+	{
+		ObjCorner corner;
+		uint8 relative = 0;	///< Bit i set: element i is a RelativeIndex
+	};
+
+	/**
+	 * \brief Results of parsing one part of a file.
+	 */
+	struct Chunk
+	{
+		const char* first = nullptr;
+		const char* last = nullptr;
+
+		std::vector<Vec4f> vPositions;
+		std::vector<Vec3f> vTexCoords;
+		std::vector<Vec4f> vNormals;
+		std::vector<ObjCorner> vCorners;
+		std::vector<RelativeIndex> vRelative;
+
+		size_t lines = 0;		///< Lines parsed
+		size_t errorLine = 0;	///< Line of error within the chunk (1-based)
+		std::string error;		///< Empty if parsed successfully
+	};
+
+	static void parseChunk(Chunk& chunk);
+	static bool parseFace(const char* p, const char* end, Chunk& chunk, std::vector<FaceCorner>& polygon);
+	bool resolveChunk(Chunk& chunk, const size_t positionBase, const size_t texCoordBase,
+		const size_t normalBase, const size_t cornerBase);
+};
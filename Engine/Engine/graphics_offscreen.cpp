@@ -0,0 +1,39 @@
+#include "graphics_offscreen.h"
+
+/**
+ * \brief Allocates pixel and depth buffers of the given size.
+ */
+OffscreenGraphics::OffscreenGraphics(const int width, const int height)
+{
+	ChangeSize(width, height);
+}
+
+/**
+ * \brief Frees pixel and depth buffers.
+ */
+OffscreenGraphics::~OffscreenGraphics()
+{
+	delete[] (colour_t*)pBuffer;
+	pBuffer = nullptr;
+	delete[] (float*)pDepthBuffer;
+	pDepthBuffer = nullptr;
+}
+
+/**
+ * \brief Reallocates pixel and depth buffers and invalidates scaled sprites.
+ * 
+ * \see Win32Graphics::ChangeSize
+ */
+void OffscreenGraphics::ChangeSize(const int newWidth, const int newHeight)
+{
+	width = newWidth;
+	height = newHeight;
+
+	delete[] (colour_t*)pBuffer;
+	pBuffer = new colour_t[width * height]();
+
+	delete[] (float*)pDepthBuffer;
+	pDepthBuffer = new float[width * height]();
+
+	onSizeChanged();
+}
@@ -0,0 +1,30 @@
+/*****************************************************************//**
+ * \file   graphics_offscreen.h
+ * \brief  Contains OffscreenGraphics class to draw without a window
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "graphics.h"
+
+/**
+ * \brief Graphics implementation whose pixel and depth buffers live in 
+ * ordinary heap memory.
+ * 
+ * Used for headless rendering (benchmarks, image comparisons) where there 
+ * is no window to present to.
+ */
+class OffscreenGraphics : public Graphics
+{
+public:
+	OffscreenGraphics(const int width, const int height);
+	~OffscreenGraphics();
+	OffscreenGraphics(const OffscreenGraphics&) = delete;
+	OffscreenGraphics& operator=(const OffscreenGraphics&) = delete;
+
+	void ChangeSize(const int newWidth, const int newHeight);
+	const colour_t* getPixels() const { return (const colour_t*)pBuffer; }
+	const float* getDepth() const { return (const float*)pDepthBuffer; }
+};
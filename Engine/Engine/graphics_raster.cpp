@@ -0,0 +1,1009 @@
+#include "graphics.h"
+#include "graphics_raster.h"
+#include <algorithm>
+
+#ifdef BLIT_SSE2
+	#include <emmintrin.h>
+#endif
+
+static_assert(BLIT_TILE_SIZE == RASTER_BLOCK_SIZE, "tiled targets are resolved with untileRect");
+
+#define RASTER_BATCH(Fill, Depth, AlphaTest) \
+	{ &Graphics::rasterBatch<Fill, Depth, AlphaTest, false>, &Graphics::rasterBatch<Fill, Depth, AlphaTest, true> }
+
+/**
+ * \brief Every variant of rasterBatch, indexed by
+ * [RasterFill][RasterDepth][alpha test][wireframe].
+ *
+ * Alpha testing only applies to RGBA textures, so Solid and RGB map both
+ * alpha test entries to the same variant. Alpha tested triangles are not
+ * drawn by a depth prepass (see rasterDepth), so they are tested with 
+ * RasterDepth::Greater instead of Equal.
+ */
+const Graphics::RasterBatchFunc Graphics::rasterBatchFuncs[3][3][2][2] =
+{
+	{	// Solid
+		{ RASTER_BATCH(RasterFill::Solid, RasterDepth::Off, false), RASTER_BATCH(RasterFill::Solid, RasterDepth::Off, false) },
+		{ RASTER_BATCH(RasterFill::Solid, RasterDepth::Greater, false), RASTER_BATCH(RasterFill::Solid, RasterDepth::Greater, false) },
+		{ RASTER_BATCH(RasterFill::Solid, RasterDepth::Equal, false), RASTER_BATCH(RasterFill::Solid, RasterDepth::Equal, false) },
+	},
+	{	// RGB
+		{ RASTER_BATCH(RasterFill::RGB, RasterDepth::Off, false), RASTER_BATCH(RasterFill::RGB, RasterDepth::Off, false) },
+		{ RASTER_BATCH(RasterFill::RGB, RasterDepth::Greater, false), RASTER_BATCH(RasterFill::RGB, RasterDepth::Greater, false) },
+		{ RASTER_BATCH(RasterFill::RGB, RasterDepth::Equal, false), RASTER_BATCH(RasterFill::RGB, RasterDepth::Equal, false) },
+	},
+	{	// RGBA
+		{ RASTER_BATCH(RasterFill::RGBA, RasterDepth::Off, false), RASTER_BATCH(RasterFill::RGBA, RasterDepth::Off, true) },
+		{ RASTER_BATCH(RasterFill::RGBA, RasterDepth::Greater, false), RASTER_BATCH(RasterFill::RGBA, RasterDepth::Greater, true) },
+		{ RASTER_BATCH(RasterFill::RGBA, RasterDepth::Equal, false), RASTER_BATCH(RasterFill::RGBA, RasterDepth::Greater, true) },
+	},
+};
+
+/**
+ * \brief Returns how triangles of parent are filled.
+ */
+static inline RasterFill rasterFillOf(const MeshInstance* parent)
+{
+	if (parent == nullptr || parent->pTexture == nullptr)
+	{
+		return RasterFill::Solid;
+	}
+	return parent->pTexture->textureType == TextureType::RGBA ? RasterFill::RGBA : RasterFill::RGB;
+}
+
+/**
+ * \brief Picks the variant of rasterBatch for triangles of parent with the
+ * current rasterOptions.
+ *
+ * \param prepassed Depth of the triangles was drawn by rasterDepth
+ */
+Graphics::RasterBatchFunc Graphics::selectRasterBatch(const MeshInstance* parent, const bool wireframe, const bool prepassed) const
+{
+	const RasterDepth depth = !rasterOptions.depthTest ? RasterDepth::Off
+		: prepassed ? RasterDepth::Equal : RasterDepth::Greater;
+	return rasterBatchFuncs
+		[(int)rasterFillOf(parent)]
+		[(int)depth]
+		[rasterOptions.alphaTest ? 1 : 0]
+		[wireframe ? 1 : 0];
+}
+
+/**
+ * \brief Draws triangles in pixel coords, as made by
+ * rasterTexturedTriangles.
+ *
+ * Triangles are split into batches of consecutive triangles with the same
+ * parent texture and hit flag. Each batch is drawn by the rasterBatch
+ * variant made for it, so the choice of fill, depth test, alpha test and
+ * outline is made once per batch instead of once per pixel.
+ *
+ * \param triangles Triangles to be drawn
+ * \param count Number of triangles
+ * \param strokeColour Colour to outline every triangle with (optional).
+ * Triangles which are hit are always outlined in red.
+ * \param prepassed Depth of the triangles was drawn by rasterDepth, so
+ * each pixel is only coloured by the triangle whose depth it holds
+ */
+void Graphics::rasterTriangles(const Triangle* triangles, const size_t count, const colour_t* strokeColour,
+	const bool prepassed)
+{
+	size_t first = 0;
+	while (first < count)
+	{
+		const Triangle& t = triangles[first];
+		const Texture* texture = t.parent != nullptr ? t.parent->pTexture : nullptr;
+
+		size_t last = first + 1;
+		while (last < count
+			&& triangles[last].hit == t.hit
+			&& (triangles[last].parent != nullptr ? triangles[last].parent->pTexture : nullptr) == texture)
+		{
+			last++;
+		}
+
+		const bool wireframe = t.hit || strokeColour != nullptr;
+		const colour_t stroke = t.hit ? 0xff0000 : (strokeColour != nullptr ? *strokeColour : 0);
+		(this->*selectRasterBatch(t.parent, wireframe, prepassed))(triangles + first, last - first, stroke);
+
+		first = last;
+	}
+}
+
+/**
+ * \brief Draws the depth (1/w) of triangles in pixel coords to 
+ * pDepthBuffer, without fetching texels or writing colour.
+ *
+ * As a depth prepass (see RasterOptions::depthPrepass), drawing the same 
+ * triangles with rasterTriangles(..., prepassed = true) afterwards colours
+ * each pixel once, by the nearest triangle. Triangles with RGBA textures
+ * are skipped while alpha testing is on, since their holes are only known
+ * by sampling them.
+ *
+ * \param triangles Triangles to be drawn
+ * \param count Number of triangles
+ */
+void Graphics::rasterDepth(const Triangle* triangles, const size_t count)
+{
+	RasterStats counts;
+
+	for (size_t n = 0; n < count; n++)
+	{
+		const Triangle& t = triangles[n];
+		if (rasterOptions.alphaTest && rasterFillOf(t.parent) == RasterFill::RGBA)
+		{
+			continue;
+		}
+		rasterTriangle<RasterFill::None, RasterDepth::Greater, false>(t, 0, counts);
+	}
+
+	addRasterCounts(counts);
+}
+
+/**
+ * \brief Draws textured triangle to pBuffer.
+ *
+ * \see rasterTriangles
+ */
+void Graphics::drawTexturedTriangle(Triangle& triangle)
+{
+	(this->*selectRasterBatch(triangle.parent, false))(&triangle, 1, 0);
+}
+
+/**
+ * \brief Adds the pixel counts of one or more rasterTriangle calls to 
+ * rasterStats.
+ */
+void Graphics::addRasterCounts(const RasterStats& counts)
+{
+	rasterStats.pixelsTested += counts.pixelsTested;
+	rasterStats.pixelsWritten += counts.pixelsWritten;
+	rasterStats.pixelsOverdrawn += counts.pixelsOverdrawn;
+	rasterStats.trianglesHidden += counts.trianglesHidden;
+}
+
+/**
+ * \brief Draws solid colour triangle with depth testing, for triangles 
+ * which have no texture (Triangle::colour).
+ * 
+ * \param triangle Triangle in pixel coords with t[].w = 1/w, as given to
+ * drawTexturedTriangle
+ * \param colour Colour of triangle
+ */
+void Graphics::fillTriangle(const Triangle& triangle, const colour_t colour)
+{
+	RasterStats counts;
+	rasterTriangle<RasterFill::Solid, RasterDepth::Greater, false>(triangle, colour, counts);
+	addRasterCounts(counts);
+}
+
+/**
+ * \brief Makes tile (tx, ty) ready to be drawn to, as needed by flags.
+ *
+ * RASTER_TILE_DEPTH clears its depth, which clearDepthBuffer left to be 
+ * cleared (see RasterOptions::fastClear). RASTER_TILE_COLOUR copies its 
+ * pixels from pBuffer to the tiled target (see RasterOptions::tiledTargets), 
+ * so triangles are drawn over what pBuffer held. Tiles never drawn to cost 
+ * nothing either way.
+ */
+void Graphics::prepareTile(const int tx, const int ty, const uint8 flags)
+{
+	const size_t tile = (size_t)ty * depthTilesX() + tx;
+	const uint8 missing = flags & ~vTileFlags[tile];
+	const int x = tx * RASTER_BLOCK_SIZE;
+	const int y = ty * RASTER_BLOCK_SIZE;
+	const int w = std::min(RASTER_BLOCK_SIZE, width - x);
+	const int h = std::min(RASTER_BLOCK_SIZE, height - y);
+
+	if (missing & RASTER_TILE_DEPTH)
+	{
+		if (rasterTiled)
+		{
+			std::fill_n(vTiledDepth.data() + tile * RASTER_TILE_PIXELS, RASTER_TILE_PIXELS, 0.0f);
+		}
+		else
+		{
+			float* depth = (float*)pDepthBuffer + (size_t)y * width + x;
+			for (int row = 0; row < h; row++, depth += width)
+			{
+				std::fill_n(depth, w, 0.0f);
+			}
+		}
+	}
+
+	if (missing & RASTER_TILE_COLOUR)
+	{
+		tileRect(vTiledColour.data() + tile * RASTER_TILE_PIXELS, (const colour_t*)pBuffer + (size_t)y * width + x,
+			width, w, h);
+	}
+
+	vTileFlags[tile] |= flags;
+}
+
+/**
+ * \brief Draws a batch of triangles which share a parent texture.
+ *
+ * \tparam Fill How pixels get their colour
+ * \tparam Depth How pixels are tested against pDepthBuffer
+ * \tparam AlphaTest Skip texels with no alpha (RGBA only)
+ * \tparam Wireframe Outline each triangle in strokeColour
+ */
+template <RasterFill Fill, RasterDepth Depth, bool AlphaTest, bool Wireframe>
+void Graphics::rasterBatch(const Triangle* triangles, const size_t count, const colour_t strokeColour)
+{
+	RasterStats counts;
+
+	for (size_t n = 0; n < count; n++)
+	{
+		const Triangle& t = triangles[n];
+		rasterTriangle<Fill, Depth, AlphaTest>(t, t.colour, counts);
+
+		if (Wireframe)
+		{
+			Vec2 v1_ = { (int)t.p[0].x, (int)t.p[0].y };
+			Vec2 v2_ = { (int)t.p[1].x, (int)t.p[1].y };
+			Vec2 v3_ = { (int)t.p[2].x, (int)t.p[2].y };
+			if (rasterTiled)
+			{
+				// Lines are drawn to pBuffer, after the tiles are resolved
+				vOutlines.push_back({ { v1_, v2_, v3_ }, strokeColour });
+			}
+			else
+			{
+				drawTriangleP(v1_, v2_, v3_, strokeColour);
+			}
+		}
+	}
+
+	addRasterCounts(counts);
+}
+
+/**
+ * \brief Edge of a triangle in fixed point (see RASTER_SUBPIXEL_BITS).
+ *
+ * E(x, y) = stepX * x + stepY * y + c at the centre of pixel (x, y) is 
+ * twice the signed area of the edge and that centre, positive on the inside
+ * of a counter-clockwise triangle.
+ */
+struct RasterEdge
+{
+	int64_t stepX;	///< Change in E per pixel right
+	int64_t stepY;	///< Change in E per pixel up
+	int64_t c;		///< E at the centre of pixel (0, 0)
+	int64_t bias;	///< Subtracted from E before testing, 0 if centres on 
+					///< the edge are inside (top-left edge), otherwise 1
+
+	/**
+	 * \brief Edge from a to b, in sub-pixels.
+	 */
+	void init(const int64_t ax, const int64_t ay, const int64_t bx, const int64_t by)
+	{
+		const int64_t a = ay - by;
+		const int64_t b = bx - ax;
+		stepX = a * RASTER_SUBPIXEL_ONE;
+		stepY = b * RASTER_SUBPIXEL_ONE;
+		c = a * (RASTER_SUBPIXEL_ONE / 2 - ax) + b * (RASTER_SUBPIXEL_ONE / 2 - ay);
+
+		// Each edge shared by two triangles is walked in opposite 
+		// directions, so exactly one of them owns centres on it
+		bias = (a > 0 || (a == 0 && b > 0)) ? 0 : 1;
+	}
+};
+
+/**
+ * \brief Returns pixel coordinate x rounded to the nearest sub-pixel.
+ *
+ * Same as floorf(x * RASTER_SUBPIXEL_ONE + 0.5f) without the library call.
+ */
+static inline int64_t snapToSubpixel(const float x)
+{
+	const float f = x * (float)RASTER_SUBPIXEL_ONE + 0.5f;
+	const int64_t i = (int64_t)f;
+	return (float)i > f ? i - 1 : i;
+}
+
+/**
+ * \brief Returns the smallest of a, b and c, by value so that it compiles 
+ * to conditional moves rather than branches which mispredict on tiny 
+ * triangles.
+ */
+static inline int64_t rasterMin3(const int64_t a, const int64_t b, const int64_t c)
+{
+	const int64_t m = a < b ? a : b;
+	return m < c ? m : c;
+}
+
+/**
+ * \brief Returns the largest of a, b and c (see rasterMin3).
+ */
+static inline int64_t rasterMax3(const int64_t a, const int64_t b, const int64_t c)
+{
+	const int64_t m = a > b ? a : b;
+	return m > c ? m : c;
+}
+
+/**
+ * \brief Attribute interpolated linearly in screen space, as 
+ * value = dx * x + dy * y + c at the centre of pixel (x, y).
+ */
+struct RasterPlane
+{
+	double dx;
+	double dy;
+	double c;
+
+	/**
+	 * \brief Plane through the values a0, a1, a2 at the corners of a 
+	 * triangle, given the coefficients of its edges (edge k opposite corner 
+	 * k) divided by its area.
+	 */
+	void init(const double ex[3], const double ey[3], const double ec[3],
+		const float a0, const float a1, const float a2)
+	{
+		dx = ex[0] * a0 + ex[1] * a1 + ex[2] * a2;
+		dy = ey[0] * a0 + ey[1] * a1 + ey[2] * a2;
+		c = ec[0] * a0 + ec[1] * a1 + ec[2] * a2;
+	}
+
+	float at(const int x, const int y) const { return (float)(dx * x + dy * y + c); }
+};
+
+/**
+ * \brief Returns true if a pixel at 1/w of w passes the Depth test against
+ * depth.
+ */
+template <RasterDepth Depth>
+static inline bool rasterDepthPass(const float w, const float depth)
+{
+	return Depth == RasterDepth::Off || (Depth == RasterDepth::Greater ? w > depth : w == depth);
+}
+
+/**
+ * \brief Samples texture at (u, v) and writes it to pixel (and depth) if
+ * it passes the alpha test.
+ */
+template <RasterFill Fill, bool AlphaTest>
+static inline void rasterTexel(const Texture& texture, const float u, const float v,
+	colour_t& pixel, float* depth, const float w, uint64_t& pixelsWritten)
+{
+	const colour_t colour = Fill == RasterFill::RGBA
+		? texture.sample<TextureType::RGBA>(u, v)
+		: texture.sample<TextureType::RGB>(u, v);
+
+	if (!AlphaTest || (colour & UINT32_ALPHA_CHANNEL) != 0)
+	{
+		pixel = colour;
+		if (depth != nullptr)
+		{
+			*depth = w;
+		}
+		pixelsWritten++;
+	}
+}
+
+/**
+ * \brief Draws a span of count pixels of a textured triangle, where u/w, 
+ * v/w and 1/w are (u, v, w) + (first + i) * (du, dv, dw) at pixel i.
+ *
+ * Values are always stepped from the same pixel of a row (see 
+ * rasterTriangle), so 1/w of a pixel does not depend on where its span 
+ * starts.
+ *
+ * With rasterOptions.perspectiveSpan of N > 1, u and v are only divided by
+ * w at every Nth pixel (and the end of the span) and stepped linearly in
+ * between. 1/w, and so the depth test, is still exact for every pixel.
+ */
+template <RasterFill Fill, RasterDepth Depth, bool AlphaTest>
+inline void Graphics::rasterTexturedSpan(colour_t* pixels, float* depth, const int first, const int count,
+	const float u, const float du, const float v, const float dv, const float w, const float dw,
+	const Texture& texture, uint64_t& pixelsWritten)
+{
+	const int span = rasterOptions.perspectiveSpan;
+
+	if (span <= 1)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const float x = (float)(first + i);
+			const float tex_w = w + x * dw;
+			if (rasterDepthPass<Depth>(tex_w, depth[i]))
+			{
+				const float invW = 1.0f / tex_w;
+				rasterTexel<Fill, AlphaTest>(texture, (u + x * du) * invW, (v + x * dv) * invW,
+					pixels[i], Depth == RasterDepth::Greater ? &depth[i] : nullptr, tex_w, pixelsWritten);
+			}
+		}
+		return;
+	}
+
+	// u, v at the start of the current segment
+	float su = (u + (float)first * du) / (w + (float)first * dw);
+	float sv = (v + (float)first * dv) / (w + (float)first * dw);
+
+	for (int i = 0; i < count; )
+	{
+		const int n = count - i < span ? count - i : span;
+
+		// u, v at the start of the next segment, or the last pixel
+		const int e = i + n < count ? i + n : count - 1;
+		const float ex = (float)(first + e);
+		const float ew = w + ex * dw;
+		const float eu = (u + ex * du) / ew;
+		const float ev = (v + ex * dv) / ew;
+
+		const float inv = e > i ? 1.0f / (float)(e - i) : 0.0f;
+		const float stepU = (eu - su) * inv;
+		const float stepV = (ev - sv) * inv;
+		float tex_u = su, tex_v = sv;
+
+		for (const int end = i + n; i < end; i++)
+		{
+			const float tex_w = w + (float)(first + i) * dw;
+			if (rasterDepthPass<Depth>(tex_w, depth[i]))
+			{
+				rasterTexel<Fill, AlphaTest>(texture, tex_u, tex_v,
+					pixels[i], Depth == RasterDepth::Greater ? &depth[i] : nullptr, tex_w, pixelsWritten);
+			}
+			tex_u += stepU;
+			tex_v += stepV;
+		}
+
+		su = eu;
+		sv = ev;
+	}
+}
+
+#if defined(BLIT_SSE2)
+/**
+ * \brief Same as rasterDepthPass of 4 pixels at once, as a mask.
+ */
+template <RasterDepth Depth>
+static inline __m128 rasterDepthPass4(const __m128 w, const float* depth)
+{
+	if (Depth == RasterDepth::Off)
+	{
+		return _mm_castsi128_ps(_mm_set1_epi32(-1));
+	}
+	const __m128 d = _mm_loadu_ps(depth);
+	return Depth == RasterDepth::Greater ? _mm_cmpgt_ps(w, d) : _mm_cmpeq_ps(w, d);
+}
+
+/**
+ * \brief Same as Texture::sample of 4 texels at once.
+ */
+template <RasterFill Fill>
+static inline __m128i rasterSample4(const Texture& texture, __m128 x, __m128 y)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	x = _mm_min_ps(_mm_max_ps(x, zero), one);
+	y = _mm_min_ps(_mm_max_ps(y, zero), one);
+
+	alignas(16) int xInd[4], yInd[4];
+	alignas(16) colour_t texels[4];
+	if (Fill == RasterFill::RGBA)
+	{
+		_mm_store_si128((__m128i*)xInd, _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(x, _mm_set1_ps(texture.stepX)), _mm_set1_ps((float)texture.width))));
+		_mm_store_si128((__m128i*)yInd, _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(y, _mm_set1_ps(texture.stepY)), _mm_set1_ps((float)texture.height))));
+
+		const colour_t* data = reinterpret_cast<const colour_t*>(texture.data);
+		for (int i = 0; i < 4; i++)
+		{
+			texels[i] = data[xInd[i] + yInd[i] * texture.width];
+		}
+	}
+	else
+	{
+		// x and y are flipped, as in Texture::lookUp
+		_mm_store_si128((__m128i*)xInd, _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(y, _mm_set1_ps((float)texture.width)), _mm_set1_ps(texture.scale))));
+		_mm_store_si128((__m128i*)yInd, _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(x, _mm_set1_ps((float)texture.height)), _mm_set1_ps(texture.scale))));
+
+		const uint8* data = reinterpret_cast<const uint8*>(texture.data);
+		for (int i = 0; i < 4; i++)
+		{
+			const uint8* texel = data + 3 * (xInd[i] * texture.width + yInd[i]);
+			texels[i] = ((colour_t)texel[2] << 16) | ((colour_t)texel[1] << 8) | (colour_t)texel[0];
+		}
+	}
+	return _mm_load_si128((const __m128i*)texels);
+}
+
+/**
+ * \brief Writes the lanes of colours (and depth w) which pass the depth and
+ * alpha tests to 4 pixels.
+ */
+template <RasterDepth Depth, bool AlphaTest>
+static inline void rasterStore4(colour_t* pixels, float* depth, const __m128 pass, 
+	const __m128i colours, const __m128 w, uint64_t& pixelsWritten)
+{
+	static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	__m128i m = _mm_castps_si128(pass);
+	if (AlphaTest)
+	{
+		const __m128i alpha = _mm_and_si128(colours, _mm_set1_epi32((int)UINT32_ALPHA_CHANNEL));
+		m = _mm_andnot_si128(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()), m);
+	}
+
+	const int mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+	if (mask == 0)
+	{
+		return;
+	}
+
+	const __m128i old = _mm_loadu_si128((const __m128i*)pixels);
+	_mm_storeu_si128((__m128i*)pixels, _mm_or_si128(_mm_and_si128(m, colours), _mm_andnot_si128(m, old)));
+	if (Depth == RasterDepth::Greater)
+	{
+		const __m128 mf = _mm_castsi128_ps(m);
+		_mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(mf, w), _mm_andnot_ps(mf, _mm_loadu_ps(depth))));
+	}
+	pixelsWritten += bitCount[mask];
+}
+#endif
+
+/**
+ * \brief Draws a run of fully covered blocks of a textured triangle, count 
+ * is a multiple of RASTER_BLOCK_SIZE. Arguments are as rasterTexturedSpan.
+ *
+ * Pixels are drawn 4 at a time with SSE2, only the texels are fetched one 
+ * by one. u and v are divided by w for every pixel, 4 divides at once cost 
+ * less than stepping them affinely (rasterOptions.perspectiveSpan).
+ */
+template <RasterFill Fill, RasterDepth Depth, bool AlphaTest>
+inline void Graphics::rasterTexturedBlocks(colour_t* pixels, float* depth, const int first, const int count,
+	const float u, const float du, const float v, const float dv, const float w, const float dw,
+	const Texture& texture, uint64_t& pixelsWritten)
+{
+#if defined(BLIT_SSE2)
+	const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 u4 = _mm_set1_ps(u), du4 = _mm_set1_ps(du);
+	const __m128 v4 = _mm_set1_ps(v), dv4 = _mm_set1_ps(dv);
+	const __m128 w4 = _mm_set1_ps(w), dw4 = _mm_set1_ps(dw);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (int i = 0; i < count; i += 4)
+	{
+		const __m128 x4 = _mm_add_ps(_mm_set1_ps((float)(first + i)), lanes);
+		const __m128 tex_w = _mm_add_ps(w4, _mm_mul_ps(x4, dw4));
+		const __m128 pass = rasterDepthPass4<Depth>(tex_w, depth + i);
+		if (_mm_movemask_ps(pass) == 0)
+		{
+			continue;  // hidden
+		}
+
+		const __m128 invW = _mm_div_ps(one, tex_w);
+		const __m128 tex_u = _mm_mul_ps(_mm_add_ps(u4, _mm_mul_ps(x4, du4)), invW);
+		const __m128 tex_v = _mm_mul_ps(_mm_add_ps(v4, _mm_mul_ps(x4, dv4)), invW);
+
+		rasterStore4<Depth, AlphaTest>(pixels + i, depth + i, pass,
+			rasterSample4<Fill>(texture, tex_u, tex_v), tex_w, pixelsWritten);
+	}
+#else
+	rasterTexturedSpan<Fill, Depth, AlphaTest>(pixels, depth, first, count, u, du, v, dv, w, dw,
+		texture, pixelsWritten);
+#endif
+}
+
+/**
+ * \brief Draws a span of count pixels of a RasterFill::Solid (or None)
+ * triangle with depth testing, where 1/w is w + (first + i) * dw at pixel
+ * i as in rasterTexturedSpan.
+ */
+template <RasterFill Fill, RasterDepth Depth>
+static inline void rasterSolidSpan(colour_t* pixels, float* depth, const int first, const int count,
+	const colour_t colour, const float w, const float dw, uint64_t& pixelsWritten)
+{
+	int i = 0;
+
+#if defined(BLIT_SSE2)
+	static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+	const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 w4 = _mm_set1_ps(w), dw4 = _mm_set1_ps(dw);
+	const __m128i c4 = _mm_set1_epi32((int)colour);
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 x4 = _mm_add_ps(_mm_set1_ps((float)(first + i)), lanes);
+		const __m128 wi = _mm_add_ps(w4, _mm_mul_ps(x4, dw4));
+		const __m128 pass = rasterDepthPass4<Depth>(wi, depth + i);
+		const int mask = _mm_movemask_ps(pass);
+		if (mask == 0)
+		{
+			continue;  // hidden
+		}
+
+		if (Fill != RasterFill::None)
+		{
+			const __m128i m = _mm_castps_si128(pass);
+			const __m128i old = _mm_loadu_si128((const __m128i*)(pixels + i));
+			_mm_storeu_si128((__m128i*)(pixels + i), _mm_or_si128(_mm_and_si128(m, c4), _mm_andnot_si128(m, old)));
+		}
+		if (Depth == RasterDepth::Greater)
+		{
+			_mm_storeu_ps(depth + i, _mm_or_ps(_mm_and_ps(pass, wi), _mm_andnot_ps(pass, _mm_loadu_ps(depth + i))));
+		}
+		pixelsWritten += bitCount[mask];
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float wi = w + (float)(first + i) * dw;
+		if (rasterDepthPass<Depth>(wi, depth[i]))
+		{
+			if (Fill != RasterFill::None)
+			{
+				pixels[i] = colour;
+			}
+			if (Depth == RasterDepth::Greater)
+			{
+				depth[i] = wi;
+			}
+			pixelsWritten++;
+		}
+	}
+}
+
+/**
+ * \brief Draws a triangle in pixel coords (t[].w = 1/w) to pBuffer.
+ *
+ * Corners are snapped to RASTER_SUBPIXEL_BITS of sub-pixel precision and 
+ * every pixel whose centre is inside all three edges is drawn, in spans 
+ * found exactly from the edge equations of each row. Centres on an edge 
+ * are only drawn if it is a top-left edge, so triangles sharing an edge 
+ * never both draw (or both miss) a pixel on it.
+ *
+ * u/w, v/w and 1/w are interpolated with plane equations from the snapped 
+ * corners.
+ *
+ * With RasterOptions::depthBounds, vTileDepth holds a depth which every 
+ * pixel of each RASTER_BLOCK_SIZE tile is known to be at or nearer than. 
+ * Triangles behind it in every tile they cover are skipped before edge
+ * setup, and tiles a triangle is behind are skipped in its spans. Blocks 
+ * a triangle fully covers raise their tile to its farthest depth.
+ *
+ * With tiled targets (see RasterOptions::tiledTargets), spans are split at
+ * tile edges, where they stop being contiguous in memory. Tiles are 
+ * prepared (see prepareTile) before a span first draws to them.
+ *
+ * \param colour Colour of RasterFill::Solid triangles
+ */
+template <RasterFill Fill, RasterDepth Depth, bool AlphaTest>
+void Graphics::rasterTriangle(const Triangle& triangle, const colour_t colour, RasterStats& counts)
+{
+	int64_t px[3], py[3];
+	for (int i = 0; i < 3; i++)
+	{
+		px[i] = snapToSubpixel(triangle.p[i].x);
+		py[i] = snapToSubpixel(triangle.p[i].y);
+	}
+
+	// Pixels whose centres are inside the bounds of the corners, clipped to 
+	// the buffer. Triangles between pixel centres are dropped here.
+	const int64_t minX = rasterMin3(px[0], px[1], px[2]);
+	const int64_t maxX = rasterMax3(px[0], px[1], px[2]);
+	const int64_t minY = rasterMin3(py[0], py[1], py[2]);
+	const int64_t maxY = rasterMax3(py[0], py[1], py[2]);
+	const int x1 = (int)std::max<int64_t>((minX + RASTER_SUBPIXEL_ONE / 2 - 1) >> RASTER_SUBPIXEL_BITS, 0);
+	const int x2 = (int)std::min<int64_t>(((maxX - RASTER_SUBPIXEL_ONE / 2) >> RASTER_SUBPIXEL_BITS) + 1, width);
+	const int y1 = (int)std::max<int64_t>((minY + RASTER_SUBPIXEL_ONE / 2 - 1) >> RASTER_SUBPIXEL_BITS, 0);
+	const int y2 = (int)std::min<int64_t>(((maxY - RASTER_SUBPIXEL_ONE / 2) >> RASTER_SUBPIXEL_BITS) + 1, height);
+	if (x1 >= x2 || y1 >= y2)
+	{
+		return;
+	}
+
+	// Triangles no nearer than the farthest depth of every tile they cover
+	// are hidden. 1/w inside the triangle is between the nearest and farthest
+	// corner, widened by the error of interpolating it.
+	float* tileDepth = nullptr;
+	const int tilesX = depthTilesX();
+	float nearW = 0.0f, farW = 0.0f;
+	if (Depth != RasterDepth::Off && rasterOptions.depthBounds
+		&& vTileDepth.size() == (size_t)tilesX * depthTilesY())
+	{
+		const float maxW = std::max(triangle.t[0].w, std::max(triangle.t[1].w, triangle.t[2].w));
+		const float minW = std::min(triangle.t[0].w, std::min(triangle.t[1].w, triangle.t[2].w));
+		nearW = maxW + maxW * RASTER_DEPTH_MARGIN;
+		farW = minW - maxW * RASTER_DEPTH_MARGIN;
+		tileDepth = vTileDepth.data();
+
+		bool hidden = true;
+		for (int ty = y1 / RASTER_BLOCK_SIZE; hidden && ty <= (y2 - 1) / RASTER_BLOCK_SIZE; ty++)
+		{
+			for (int tx = x1 / RASTER_BLOCK_SIZE; tx <= (x2 - 1) / RASTER_BLOCK_SIZE; tx++)
+			{
+				if (nearW > tileDepth[ty * tilesX + tx])
+				{
+					hidden = false;
+					break;
+				}
+			}
+		}
+		if (hidden)
+		{
+			counts.trianglesHidden++;
+			return;
+		}
+	}
+
+	// Twice the signed area, edges are walked counter-clockwise whichever way
+	// the corners are given. Edge k is opposite corner k.
+	int64_t area = (px[2] - px[1]) * (py[0] - py[1]) - (py[2] - py[1]) * (px[0] - px[1]);
+	if (area == 0)
+	{
+		return;
+	}
+	const bool ccw = area > 0;
+	area = ccw ? area : -area;
+
+	RasterEdge edge[3];
+	for (int k = 0; k < 3; k++)
+	{
+		const int a = ccw ? (k + 1) % 3 : (k + 2) % 3;
+		const int b = ccw ? (k + 2) % 3 : (k + 1) % 3;
+		edge[k].init(px[a], py[a], px[b], py[b]);
+	}
+
+	const bool textured = Fill == RasterFill::RGB || Fill == RasterFill::RGBA;
+	RasterPlane planeU, planeV, planeW;
+	{
+		const double invArea = 1.0 / (double)area;
+		const double ex[3] = { edge[0].stepX * invArea, edge[1].stepX * invArea, edge[2].stepX * invArea };
+		const double ey[3] = { edge[0].stepY * invArea, edge[1].stepY * invArea, edge[2].stepY * invArea };
+		const double ec[3] = { edge[0].c * invArea, edge[1].c * invArea, edge[2].c * invArea };
+		if (textured)
+		{
+			planeU.init(ex, ey, ec, triangle.t[0].u, triangle.t[1].u, triangle.t[2].u);
+			planeV.init(ex, ey, ec, triangle.t[0].v, triangle.t[1].v, triangle.t[2].v);
+		}
+		planeW.init(ex, ey, ec, triangle.t[0].w, triangle.t[1].w, triangle.t[2].w);
+	}
+	const float du = textured ? (float)planeU.dx : 0.0f;
+	const float dv = textured ? (float)planeV.dx : 0.0f;
+	const float dw = (float)planeW.dx;
+
+	const Texture* texture = textured ? triangle.parent->pTexture : nullptr;
+	uint8* overdraw = vOverdraw.size() == (size_t)width * height ? vOverdraw.data() : nullptr;
+	const bool tiled = rasterTiled;
+	colour_t* targetColour = tiled ? vTiledColour.data() : (colour_t*)pBuffer;
+	float* targetDepth = tiled ? vTiledDepth.data() : (float*)pDepthBuffer;
+	uint8* tileFlags = vTileFlags.size() == (size_t)tilesX * depthTilesY() ? vTileFlags.data() : nullptr;
+	const uint8 tileNeeds = (Depth != RasterDepth::Off ? RASTER_TILE_DEPTH : 0)
+		| (tiled && Fill != RasterFill::None ? RASTER_TILE_COLOUR : 0);
+
+	// Spans of each row are drawn with rasterTexturedSpan, except where they 
+	// cross RASTER_BLOCK_SIZE square blocks which are fully covered. Those 
+	// runs are drawn with rasterTexturedBlocks, which needs no clipping or
+	// tail handling. Values are stepped from x1 whatever the span, so a 
+	// depth prepass writes the same 1/w as is tested when colouring.
+	auto drawSpan = [&](const int y, const int xs, const int n, const bool fullBlocks)
+	{
+		const int row = y * width + xs;
+		counts.pixelsTested += n;
+		if (overdraw != nullptr && Fill != RasterFill::None)
+		{
+			uint8* covered = overdraw + row;
+			for (int x = 0; x < n; x++)
+			{
+				counts.pixelsOverdrawn += covered[x];
+				covered[x] = 1;
+			}
+		}
+
+		if (tileFlags != nullptr && tileNeeds != 0)
+		{
+			const int ty = y / RASTER_BLOCK_SIZE;
+			const uint8* flags = tileFlags + ty * tilesX;
+			for (int tx = xs / RASTER_BLOCK_SIZE; tx <= (xs + n - 1) / RASTER_BLOCK_SIZE; tx++)
+			{
+				if ((flags[tx] & tileNeeds) != tileNeeds)
+				{
+					prepareTile(tx, ty, tileNeeds);
+				}
+			}
+		}
+
+		const float u = textured ? planeU.at(x1, y) : 0.0f;
+		const float v = textured ? planeV.at(x1, y) : 0.0f;
+		const float w = planeW.at(x1, y);
+		auto drawPixels = [&](const size_t offset, const int first, const int count)
+		{
+			colour_t* pixels = targetColour + offset;
+			float* depth = targetDepth + offset;
+			if (Fill == RasterFill::Solid && Depth == RasterDepth::Off)
+			{
+				fillRow(pixels, colour, count);
+				counts.pixelsWritten += count;
+			}
+			else if (!textured)
+			{
+				rasterSolidSpan<Fill, Depth>(pixels, depth, first, count, colour, w, dw, counts.pixelsWritten);
+			}
+			else if (fullBlocks)
+			{
+				rasterTexturedBlocks<Fill, Depth, AlphaTest>(pixels, depth, first, count,
+					u, du, v, dv, w, dw, *texture, counts.pixelsWritten);
+			}
+			else
+			{
+				rasterTexturedSpan<Fill, Depth, AlphaTest>(pixels, depth, first, count,
+					u, du, v, dv, w, dw, *texture, counts.pixelsWritten);
+			}
+		};
+
+		if (!tiled)
+		{
+			drawPixels(row, xs - x1, n);
+			return;
+		}
+
+		for (int x = xs; x < xs + n;)
+		{
+			const int end = std::min((x & ~(RASTER_BLOCK_SIZE - 1)) + RASTER_BLOCK_SIZE, xs + n);
+			drawPixels(rasterTileOffset(x, y, tilesX), x - x1, end - x);
+			x = end;
+		}
+	};
+
+	// Draws [l, r) of row y, where the part of it inside [blockLeft,
+	// blockRight) is fully covered blocks
+	auto drawRun = [&](const int y, const int l, const int r, const int blockLeft, const int blockRight)
+	{
+		const int bl = blockLeft > l ? blockLeft : l;
+		const int br = blockRight < r ? blockRight : r;
+		if (bl < br)
+		{
+			if (l < bl) drawSpan(y, l, bl - l, false);
+			drawSpan(y, bl, br - bl, true);
+			if (br < r) drawSpan(y, br, r - br, false);
+		}
+		else
+		{
+			drawSpan(y, l, r - l, false);
+		}
+	};
+
+	// Draws span [l, r) of row y, where [blockLeft, blockRight) is a run of
+	// fully covered blocks inside it (or empty). Pixels in tiles of the row 
+	// (if given) which the triangle is hidden behind are skipped.
+	auto drawRow = [&](const int y, const int l, const int r, const int blockLeft, const int blockRight,
+		const float* tiles)
+	{
+		if (tiles == nullptr)
+		{
+			drawRun(y, l, r, blockLeft, blockRight);
+			return;
+		}
+
+		int x = l;
+		while (x < r)
+		{
+			int end = std::min((x & ~(RASTER_BLOCK_SIZE - 1)) + RASTER_BLOCK_SIZE, r);
+			if (nearW <= tiles[x / RASTER_BLOCK_SIZE])
+			{
+				x = end;
+				continue;
+			}
+			while (end < r && nearW > tiles[end / RASTER_BLOCK_SIZE])
+			{
+				end = std::min(end + RASTER_BLOCK_SIZE, r);
+			}
+			drawRun(y, x, end, blockLeft, blockRight);
+			x = end;
+		}
+	};
+
+	// Small triangles (distant faces) find the span of each row by stepping
+	// the edge functions across the bounding box, which costs less than 
+	// solving them per row
+	if (x2 - x1 <= RASTER_SMALL_SIZE && y2 - y1 <= RASTER_SMALL_SIZE)
+	{
+		for (int y = y1; y < y2; y++)
+		{
+			int64_t e0 = edge[0].c + edge[0].stepY * y + edge[0].stepX * x1 - edge[0].bias;
+			int64_t e1 = edge[1].c + edge[1].stepY * y + edge[1].stepX * x1 - edge[1].bias;
+			int64_t e2 = edge[2].c + edge[2].stepY * y + edge[2].stepX * x1 - edge[2].bias;
+			int l = x2, r = x2;
+			for (int x = x1; x < x2; x++)
+			{
+				if ((e0 | e1 | e2) >= 0)
+				{
+					l = l < x ? l : x;
+					r = x + 1;
+				}
+				e0 += edge[0].stepX;
+				e1 += edge[1].stepX;
+				e2 += edge[2].stepX;
+			}
+			if (l < r)
+			{
+				drawRow(y, l, r, 0, 0,
+					tileDepth != nullptr ? tileDepth + (y / RASTER_BLOCK_SIZE) * tilesX : nullptr);
+			}
+		}
+		return;
+	}
+
+	for (int band = y1 & ~(RASTER_BLOCK_SIZE - 1); band < y2; band += RASTER_BLOCK_SIZE)
+	{
+		const int yb1 = band > y1 ? band : y1;
+		const int yb2 = band + RASTER_BLOCK_SIZE < y2 ? band + RASTER_BLOCK_SIZE : y2;
+
+		// Span of centres inside all edges on each row: E(x) - bias >= 0
+		int left[RASTER_BLOCK_SIZE], right[RASTER_BLOCK_SIZE];
+		int innerLeft = x1, innerRight = x2;
+		for (int y = yb1; y < yb2; y++)
+		{
+			int64_t l = x1, r = x2;
+			for (int k = 0; k < 3; k++)
+			{
+				const int64_t e = edge[k].c + edge[k].stepY * y - edge[k].bias;
+				if (edge[k].stepX > 0)
+				{
+					l = std::max(l, -floorDiv(e, edge[k].stepX));
+				}
+				else if (edge[k].stepX < 0)
+				{
+					r = std::min(r, floorDiv(e, -edge[k].stepX) + 1);
+				}
+				else if (e < 0)
+				{
+					r = l;
+				}
+			}
+			left[y - band] = (int)l;
+			right[y - band] = (int)(r > l ? r : l);
+			innerLeft = std::max(innerLeft, left[y - band]);
+			innerRight = std::min(innerRight, right[y - band]);
+		}
+
+		// Blocks inside the spans of all rows of the band are fully covered, 
+		// the spans already skip blocks outside the triangle
+		int blockLeft = 0, blockRight = 0;
+		if (yb2 - yb1 == RASTER_BLOCK_SIZE)
+		{
+			blockLeft = (innerLeft + RASTER_BLOCK_SIZE - 1) & ~(RASTER_BLOCK_SIZE - 1);
+			blockRight = innerRight & ~(RASTER_BLOCK_SIZE - 1);
+		}
+
+		// Tiles of the band are only looked up per row if it is hidden 
+		// behind any of them
+		const float* hiddenTiles = nullptr;
+		if (tileDepth != nullptr)
+		{
+			const float* tiles = tileDepth + (band / RASTER_BLOCK_SIZE) * tilesX;
+			for (int tx = x1 / RASTER_BLOCK_SIZE; tx <= (x2 - 1) / RASTER_BLOCK_SIZE; tx++)
+			{
+				if (nearW <= tiles[tx])
+				{
+					hiddenTiles = tiles;
+					break;
+				}
+			}
+		}
+
+		for (int y = yb1; y < yb2; y++)
+		{
+			const int l = left[y - band];
+			const int r = right[y - band];
+			if (l >= r)
+			{
+				continue;
+			}
+
+			drawRow(y, l, r, blockLeft, blockRight, hiddenTiles);
+		}
+
+		// Every pixel of a fully covered block now holds at least farW,
+		// unless alpha testing left holes in it
+		if (tileDepth != nullptr && Depth == RasterDepth::Greater && !AlphaTest)
+		{
+			float* tiles = tileDepth + (band / RASTER_BLOCK_SIZE) * tilesX;
+			for (int x = blockLeft; x < blockRight; x += RASTER_BLOCK_SIZE)
+			{
+				float& tile = tiles[x / RASTER_BLOCK_SIZE];
+				tile = tile > farW ? tile : farW;
+			}
+		}
+	}
+}
@@ -0,0 +1,115 @@
+/*****************************************************************//**
+ * \file   graphics_raster.h
+ * \brief  Contains the switches which select a variant of the 3D raster
+ * pipeline and the fixed point precision it snaps corners to
+ *
+ * Each variant is a Graphics::rasterBatch instantiated at compile time
+ * (see graphics_raster.cpp), so its inner loop only contains the work that
+ * variant needs.
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+
+#define RASTER_SUBPIXEL_BITS	(8)		///< Fractional bits of snapped corners
+#define RASTER_SUBPIXEL_ONE		(1 << RASTER_SUBPIXEL_BITS)
+#define RASTER_SMALL_SIZE		(4)		///< Largest bounds (in pixels) of 
+										///< triangles drawn by the small path
+#define RASTER_BLOCK_SIZE		(8)		///< Width and height of blocks 
+										///< classified as fully covered and
+										///< of depth bounds tiles
+#define RASTER_DEPTH_MARGIN		(1e-5f)	///< Relative error allowed for 1/w
+										///< interpolated inside a triangle
+#define RASTER_TILE_PIXELS		(RASTER_BLOCK_SIZE * RASTER_BLOCK_SIZE)
+
+#define RASTER_NEAR_PLANE		(0.1f)	///< Camera z triangles are clipped at
+
+#define RASTER_VERTEX_CAMERA	(1 << 0)	///< Graphics::RasterVertex::camera is set
+#define RASTER_VERTEX_SCREEN	(1 << 1)	///< Graphics::RasterVertex::screen is set
+
+#define RASTER_TILE_DEPTH		(1 << 0)	///< Depth of tile is cleared
+#define RASTER_TILE_COLOUR		(1 << 1)	///< Colour of tile is copied to the
+											///< tiled target
+
+/**
+ * \brief How the pixels of a triangle get their colour.
+ */
+enum class RasterFill : int
+{
+	Solid	= 0,	///< Triangle::colour, no texture
+	RGB		= 1,	///< Texture of TextureType::RGB
+	RGBA	= 2,	///< Texture of TextureType::RGBA
+	None	= 3,	///< No colour, only depth is written (see 
+					///< Graphics::rasterDepth)
+};
+
+/**
+ * \brief How the pixels of a triangle are tested against pDepthBuffer.
+ *
+ * 1/w of a pixel is computed the same way in every variant, so a triangle
+ * drawn with Equal finds exactly the values it wrote with Greater.
+ */
+enum class RasterDepth : int
+{
+	Off		= 0,	///< Not tested or written
+	Greater	= 1,	///< Drawn where 1/w is greater (nearer), which is written
+	Equal	= 2,	///< Drawn where 1/w is equal, as written by a depth 
+					///< prepass, nothing is written
+};
+
+/**
+ * \brief Options applied to every triangle drawn by
+ * Graphics::rasterTexturedTriangles.
+ */
+struct RasterOptions
+{
+	bool depthTest = true;	///< Test against and write to pDepthBuffer
+	bool alphaTest = true;	///< Skip texels of RGBA textures with no alpha
+	int perspectiveSpan = 0;	///< Pixels between exact perspective divides
+								///< of u/v, interpolated affinely in between
+								///< (0 or 1 = divide every pixel)
+	bool countOverdraw = false;	///< Count pixels covered more than once
+								///< between clearDepthBuffer calls (see 
+								///< RasterStats::pixelsOverdrawn)
+	bool depthBounds = true;	///< Skip triangles, or the parts of them,
+								///< behind the farthest depth of every tile
+								///< they cover (see RasterStats::trianglesHidden)
+	bool depthPrepass = false;	///< Draw the depth of opaque triangles first,
+								///< then colour only pixels they are nearest
+								///< in (see RasterDepth::Equal)
+	bool frontToBack = true;	///< Draw objects front to back, alpha tested
+								///< objects last (see RenderQueue)
+	bool tiledTargets = false;	///< Draw colour and depth in RASTER_BLOCK_SIZE
+								///< tiles from clearDepthBuffer, copied to 
+								///< pBuffer by Graphics::resolveRasterTargets
+	bool fastClear = false;		///< clearDepthBuffer only flags tiles, which are
+								///< cleared when first drawn to. Depth of tiles
+								///< never drawn to is only valid through 
+								///< Graphics::readDepthBuffer
+};
+
+/**
+ * \brief Returns a / b rounded towards negative infinity, for b > 0.
+ */
+inline int64_t floorDiv(const int64_t a, const int64_t b)
+{
+	const int64_t q = a / b;
+	return (a % b != 0 && a < 0) ? q - 1 : q;
+}
+
+/**
+ * \brief Returns the index of pixel (x, y) in a buffer of RASTER_BLOCK_SIZE
+ * tiles which is tilesX tiles wide (see tileRect).
+ */
+inline size_t rasterTileOffset(const int x, const int y, const int tilesX)
+{
+	const uint tx = (uint)x / RASTER_BLOCK_SIZE;
+	const uint ty = (uint)y / RASTER_BLOCK_SIZE;
+	return ((size_t)ty * tilesX + tx) * RASTER_TILE_PIXELS
+		+ ((uint)y % RASTER_BLOCK_SIZE) * RASTER_BLOCK_SIZE + (uint)x % RASTER_BLOCK_SIZE;
+}
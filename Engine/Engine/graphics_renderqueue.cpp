@@ -0,0 +1,91 @@
+#include "graphics_renderqueue.h"
+#include "graphics_objects.h"
+#include "graphics_texture.h"
+#include <cstring>
+
+#define RENDER_QUEUE_ALPHA_KEY	(0x8000)	///< Set in keys of alpha tested objects
+
+/**
+ * \brief Returns the 15 bit depth key of an object at squared distance
+ * distSq, shared by RenderQueue and RenderCommandBuffer so both order
+ * objects the same way.
+ *
+ * Distances are positive, so the top bits of the float sort as an integer.
+ */
+uint renderDepthKey(const float distSq)
+{
+	uint bits;
+	std::memcpy(&bits, &distSq, sizeof(bits));
+	return (bits >> 16) & 0x7fff;
+}
+
+/**
+ * \brief Returns the sort key of an object at squared distance distSq.
+ */
+static inline uint renderQueueKey(const float distSq, const bool alphaTested)
+{
+	return renderDepthKey(distSq) | (alphaTested ? RENDER_QUEUE_ALPHA_KEY : 0);
+}
+
+/**
+ * \brief Sorts objects front to back, alpha tested objects last.
+ *
+ * \param objects Objects to be drawn
+ * \param vCamera Position of camera
+ * \return Objects in the order they should be drawn (same as getObjects)
+ */
+const std::vector<MeshInstance*>& RenderQueue::sort(const std::vector<MeshInstance*>& objects, const Vec4f& vCamera)
+{
+	const size_t count = objects.size();
+	vItems.resize(count);
+	vScratch.resize(count);
+
+	// Histograms of both key bytes are made in the same pass as the keys
+	size_t histogram[2][256] = {};
+	for (size_t i = 0; i < count; i++)
+	{
+		const MeshInstance* o = objects[i];
+		const Vec4f vOrigin = o->matrixWorldPos * Vec4f(0.0f, 0.0f, 0.0f);
+		const Vec4f vRay = vOrigin - vCamera;
+		const bool alphaTested = o->pTexture != nullptr && o->pTexture->textureType == TextureType::RGBA;
+
+		const uint key = renderQueueKey(Vec4f::DotProduct(vRay, vRay), alphaTested);
+		vItems[i].key = key;
+		vItems[i].index = (uint)i;
+		histogram[0][key & 0xff]++;
+		histogram[1][key >> 8]++;
+	}
+
+	// Least significant byte first, each pass is stable. Passes where every
+	// key has the same byte would not move anything and are skipped.
+	for (int pass = 0; pass < 2; pass++)
+	{
+		const int shift = pass * 8;
+		size_t* counts = histogram[pass];
+		if (count == 0 || counts[(vItems[0].key >> shift) & 0xff] == count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			const size_t n = counts[b];
+			counts[b] = offset;
+			offset += n;
+		}
+
+		for (const RenderQueueItem& item : vItems)
+		{
+			vScratch[counts[(item.key >> shift) & 0xff]++] = item;
+		}
+		vItems.swap(vScratch);
+	}
+
+	vObjects.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		vObjects[i] = objects[vItems[i].index];
+	}
+	return vObjects;
+}
@@ -0,0 +1,51 @@
+/*****************************************************************//**
+ * \file   graphics_renderqueue.h
+ * \brief  Contains RenderQueue class to order objects front to back before
+ * their triangles are rasterised
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include "utils_vector.h"
+#include <vector>
+
+struct MeshInstance;
+
+/**
+ * \brief Object to be drawn and the key it is sorted by.
+ */
+struct RenderQueueItem
+{
+	uint key;	///< Quantised depth key (see RenderQueue::sort)
+	uint index;	///< Index of object in the list given to RenderQueue::sort
+};
+
+/**
+ * \brief Orders objects front to back by the distance from the camera to
+ * their origin.
+ *
+ * Drawn in this order, the depth test (and tile depth bounds, see
+ * RasterOptions::depthBounds) rejects most pixels of objects behind others
+ * before any texture is sampled. Objects with RGBA textures are alpha
+ * tested and leave holes, so they are ordered after every opaque object.
+ *
+ * Keys are 16 bits: the top half of the distance squared as a float (which
+ * sorts as an integer for positive floats), with the top bit set for alpha
+ * tested objects. They are sorted with a stable two pass radix sort.
+ */
+class RenderQueue
+{
+private:
+	std::vector<RenderQueueItem> vItems;	///< Items being sorted
+	std::vector<RenderQueueItem> vScratch;	///< Output of each radix pass
+	std::vector<MeshInstance*> vObjects;			///< Objects in sorted order
+
+public:
+	const std::vector<MeshInstance*>& sort(const std::vector<MeshInstance*>& objects, const Vec4f& vCamera);
+	const std::vector<MeshInstance*>& getObjects() const { return vObjects; }
+};
+
+extern uint renderDepthKey(const float distSq);
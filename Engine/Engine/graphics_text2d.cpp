@@ -65,16 +65,55 @@ const bool Text2D::LoadTextMapFromBMP(const char* filename)
 	f.seekg(head.offset);
 	f.read((int8*)& pCharMap[0], filesize);
 
-	for (int y = height - 1; y >= 0; y--)
+	f.close();
+
+	buildGlyphCache();
+	return true;
+}
+
+/**
+ * \brief Expands every accepted char from pCharMap into glyphs and fills
+ * glyphIndex so glyphs can be found without searching acceptedChars.
+ * 
+ * Each glyph covers the same TEXT2D_GLYPH_ROWS x TEXT2D_GLYPH_WIDTH pixels 
+ * that were previously read bit by bit when drawing. Rows outside of the 
+ * map are left empty.
+ */
+void Text2D::buildGlyphCache()
+{
+	glyphs.assign(acceptedChars.size(), Glyph());
+	for (auto& i : glyphIndex)
 	{
-		for (int x = 0; x < width; x++)
+		i = -1;
+	}
+
+	for (size_t charIndex = 0; charIndex < acceptedChars.size(); charIndex++)
+	{
+		glyphIndex[(uint8)acceptedChars[charIndex]] = (int16_t)charIndex;
+
+		// Find char in texture
+		const int ind_x = (int)charIndex % TEXT2D_GLYPHS_PER_ROW;
+		const int ind_y = (int)charIndex / TEXT2D_GLYPHS_PER_ROW;
+		const int top = (height - 1) - (TEXT2D_GLYPH_HEIGHT * ind_y);
+		const int bottom = top - TEXT2D_GLYPH_HEIGHT;
+		const int left = TEXT2D_GLYPH_WIDTH * ind_x;
+
+		Glyph& glyph = glyphs[charIndex];
+		for (int row = 0; row < TEXT2D_GLYPH_ROWS; row++)
 		{
-			int pos = y * linesize + x / 8;
-			int bit = 1 << (7 - x % 8);
-			int v = (pCharMap[pos] & bit) > 0;
+			const int y = bottom + row;
+			if (y < 0 || y >= height)
+			{
+				continue;
+			}
+
+			for (int col = 0; col < TEXT2D_GLYPH_WIDTH; col++)
+			{
+				const int x = left + col;
+				const int pos = y * linesize + x / 8;
+				const int bit = 1 << (7 - x % 8);
+				glyph.coverage[row][col] = (pCharMap[pos] & bit) > 0 ? 1 : 0;
+			}
 		}
 	}
-
-	f.close();
-	return true;
 }
\ No newline at end of file
@@ -8,6 +8,14 @@
 
 #pragma once
 #include "utils_vector.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define TEXT2D_GLYPH_WIDTH		(14)	///< Width of each glyph in pixels
+#define TEXT2D_GLYPH_HEIGHT		(18)	///< Height of each glyph in the character map
+#define TEXT2D_GLYPH_ROWS		(TEXT2D_GLYPH_HEIGHT + 1)	///< Rows drawn for each glyph
+#define TEXT2D_GLYPHS_PER_ROW	(18)	///< Glyphs in each row of the character map
 
 // https://stackoverflow.com/questions/49215933/reading-a-monochrome-bitmap-in-c-requires-reading-every-other-line
 
@@ -28,6 +36,17 @@ struct BmpHeader {
 };
 #pragma pack()
 
+/**
+ * \brief Glyph expanded from the 1-bpp character map, one byte per pixel.
+ * 
+ * Row 0 is the bottom row of the glyph. Coverage is 1 where the glyph is 
+ * drawn, otherwise 0.
+ */
+struct Glyph
+{
+	uint8 coverage[TEXT2D_GLYPH_ROWS][TEXT2D_GLYPH_WIDTH];
+};
+
 /**
  * \brief Contains byte array containing character "texture" map.
  */
@@ -47,7 +66,22 @@ public:
 													///< these chars will be 
 													///< valid to draw/input
 
+private:
+	std::vector<Glyph> glyphs;		///< Expanded glyph of every accepted char
+	int16_t glyphIndex[256];		///< Index into glyphs for every char, -1 if not accepted
+
+	void buildGlyphCache();
+
 public:
 	~Text2D();
 	const bool LoadTextMapFromBMP(const char* filename);
+
+	/**
+	 * \brief Returns expanded glyph of c, or nullptr if c is not accepted.
+	 */
+	inline const Glyph* getGlyph(const char c) const
+	{
+		const int16_t i = glyphIndex[(uint8)c];
+		return i < 0 ? nullptr : &glyphs[i];
+	}
 };
\ No newline at end of file
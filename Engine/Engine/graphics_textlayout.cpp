@@ -0,0 +1,106 @@
+#include "graphics_textlayout.h"
+#include "graphics_text2d.h"
+#include <cstdarg>
+#include <cstdio>
+
+#define TEXT_LAYOUT_MAX_FORMAT (256)	///< Longest string format() can produce
+
+/**
+ * \brief Sets content of the layout.
+ * 
+ * \return Returns true if content changed, otherwise false
+ */
+const bool TextLayout::setText(const std::string& str)
+{
+	if (!dirty && str == text)
+	{
+		return false;
+	}
+
+	text = str;
+	dirty = true;
+	return true;
+}
+
+/**
+ * \brief Sets content of the layout with printf style formatting.
+ * 
+ * \return Returns true if content changed, otherwise false
+ */
+const bool TextLayout::format(const char* fmt, ...)
+{
+	char buffer[TEXT_LAYOUT_MAX_FORMAT];
+
+	va_list args;
+	va_start(args, fmt);
+	int length = vsnprintf(buffer, sizeof(buffer), fmt, args);
+	va_end(args);
+
+	if (length < 0)
+	{
+		length = 0;
+	}
+	else if (length >= (int)sizeof(buffer))
+	{
+		length = (int)sizeof(buffer) - 1;
+	}
+
+	if (!dirty && text.size() == (size_t)length && text.compare(0, length, buffer, length) == 0)
+	{
+		return false;
+	}
+
+	text.assign(buffer, length);
+	dirty = true;
+	return true;
+}
+
+/**
+ * \brief Rasterises content into runs if it changed since the last 
+ * layout.
+ * 
+ * Chars which are not accepted by text2D advance the pen without drawing,
+ * as in Graphics::drawGlyphRun. Runs which continue across neighbouring 
+ * glyphs are merged.
+ */
+void TextLayout::layout(const Text2D& text2D)
+{
+	if (!dirty)
+	{
+		return;
+	}
+
+	vRuns.clear();
+	width = (int)text.size() * TEXT2D_GLYPH_WIDTH;
+	height = TEXT2D_GLYPH_ROWS;
+
+	for (int row = 0; row < TEXT2D_GLYPH_ROWS; row++)
+	{
+		int runStart = -1;
+		for (size_t i = 0; i <= text.size(); i++)
+		{
+			const Glyph* glyph = i < text.size() ? text2D.getGlyph(text[i]) : nullptr;
+			for (int col = 0; col < TEXT2D_GLYPH_WIDTH; col++)
+			{
+				const int x = (int)i * TEXT2D_GLYPH_WIDTH + col;
+				const bool covered = glyph != nullptr && glyph->coverage[row][col];
+				if (covered && runStart < 0)
+				{
+					runStart = x;
+				}
+				else if (!covered && runStart >= 0)
+				{
+					vRuns.push_back({ (int16_t)runStart, (int16_t)row, (int16_t)(x - runStart) });
+					runStart = -1;
+				}
+
+				if (i == text.size())
+				{
+					break;  // only needed to close the last run
+				}
+			}
+		}
+	}
+
+	dirty = false;
+}
@@ -0,0 +1,82 @@
+/*****************************************************************//**
+ * \file   graphics_textlayout.h
+ * \brief  Contains TextLayout class to retain laid out text between 
+ * frames
+ * 
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class Text2D;
+
+/**
+ * \brief Horizontal run of covered pixels, relative to the bottom-left of 
+ * the text.
+ */
+struct TextRun
+{
+	int16_t x;		///< First pixel of run
+	int16_t y;		///< Row of run (0 = bottom)
+	int16_t length;	///< Number of pixels in run
+};
+
+/**
+ * \brief Text that is laid out once and redrawn until its content 
+ * changes.
+ * 
+ * The string is rasterised from the glyph cache into runs of covered 
+ * pixels, so drawing is a handful of solid fills per row and no glyph 
+ * lookups. Setting the same text again is a string compare; the runs are 
+ * only rebuilt when the content differs.
+ * 
+ * For values formatted every frame, updateKey() can be used to skip 
+ * formatting entirely while the displayed values are unchanged.
+ * 
+ * \see Graphics::drawTextLayout
+ */
+class TextLayout
+{
+private:
+	std::string text;				///< Current content
+	std::vector<TextRun> vRuns;		///< Rasterised content
+	std::vector<uint8> key;			///< Values content was formatted from
+	bool dirty = true;				///< vRuns needs to be rebuilt
+	int width = 0;					///< Width of content in pixels
+	int height = 0;					///< Height of content in pixels
+
+public:
+	const bool setText(const std::string& str);
+	const bool format(const char* fmt, ...);
+	void layout(const Text2D& text2D);
+
+	/**
+	 * \brief Stores the values the content is made from.
+	 * 
+	 * \return Returns true if value differs from the previous call (the 
+	 * content should be formatted again), otherwise false
+	 */
+	template <typename T>
+	const bool updateKey(const T& value)
+	{
+		if (key.size() == sizeof(T) && memcmp(key.data(), &value, sizeof(T)) == 0)
+		{
+			return false;
+		}
+		key.resize(sizeof(T));
+		memcpy(key.data(), &value, sizeof(T));
+		return true;
+	}
+
+	const std::string& getText() const { return text; }
+	const std::vector<TextRun>& getRuns() const { return vRuns; }
+	const bool isDirty() const { return dirty; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+};
@@ -27,6 +27,44 @@ Texture::Texture(TextureType textureType, const char* filename, const int sectio
 	}
 }
 
+/**
+ * \brief Allocates a blank texture to be filled in memory (e.g. generated
+ * patterns), without reading a file.
+ * 
+ * Pixels are laid out exactly as loadTextureFromBMP would store them, 
+ * 3 bytes (BGR) per pixel for RGB and one colour_t per pixel for RGBA, and
+ * are initialised to 0.
+ * 
+ * \param textureType Describes how data is to be stored
+ * \param width Width of texture in pixels
+ * \param height Height of texture in pixels
+ * \param sectionWidth Width of each slice in texture in pixels
+ * \param sectionHeight Height of each slice in texture in pixels
+ */
+Texture::Texture(TextureType textureType, const int width, const int height, const int sectionWidth, const int sectionHeight)
+	: textureType(textureType), width(width), height(height)
+{
+	assert(width > 0 && height > 0);
+	assert(sectionWidth > 0 && width % sectionWidth == 0);
+	assert(sectionHeight > 0 && height % sectionHeight == 0);
+
+	scale = (float)width / (float)height;
+	maxCylcesX = width / sectionWidth;
+	maxCylcesY = height / sectionHeight;
+	stepX = 1.0f / maxCylcesX;
+	stepY = 1.0f / maxCylcesY;
+
+	switch (textureType)
+	{
+	case TextureType::RGB:
+		data = new uint8[3 * width * height]();
+		break;
+	case TextureType::RGBA:
+		data = new uint[width * height]();
+		break;
+	}
+}
+
 /**
  * \brief Destroys data if it exists.
  */
@@ -47,7 +85,7 @@ Texture::~Texture()
 bool Texture::loadTextureFromBMP(const char* filename, const int sectionWidth, const int sectionHeight)
 {
 	FILE* file;
-	errno_t err = fopen_s(&file, filename, "r");
+	errno_t err = fopen_s(&file, filename, "rb");
 	if (err != 0)
 	{
 		std::cerr << "Error opening file " << filename << "\n";
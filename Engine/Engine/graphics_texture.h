@@ -36,7 +36,45 @@ struct Texture
 	float stepY;				///< Multiplyer to slice texture in y-axis
 		
 	Texture(TextureType textureType, const char* filename, const int sectionWidth, const int sectionHeight);
+	Texture(TextureType textureType, const int width, const int height, const int sectionWidth, const int sectionHeight);
 	~Texture();
 	bool loadTextureFromBMP(const char* filename, const int sectionWidth, const int sectionHeight);
 	colour_t lookUp(const float x, const float y, int cycleX = 0, int cycleY = 0) const;
+
+	template <TextureType Type>
+	inline colour_t sample(float x, float y) const;
 };
+
+/**
+ * \brief Same as lookUp of an RGB texture, for inner loops which already 
+ * know the texture type.
+ */
+template <>
+inline colour_t Texture::sample<TextureType::RGB>(float x, float y) const
+{
+	x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+	y = y < 0.0f ? 0.0f : (y > 1.0f ? 1.0f : y);
+
+	// x and y are flipped, as in lookUp
+	const int xInd = (int)(y * (float)width / scale);
+	const int yInd = (int)(x * (float)height * scale);
+
+	const uint8* texel = reinterpret_cast<const uint8*>(data) + 3 * (xInd * width + yInd);
+	return ((colour_t)texel[2] << 16) | ((colour_t)texel[1] << 8) | (colour_t)texel[0];
+}
+
+/**
+ * \brief Same as lookUp of the first slice of an RGBA texture, for inner 
+ * loops which already know the texture type.
+ */
+template <>
+inline colour_t Texture::sample<TextureType::RGBA>(float x, float y) const
+{
+	x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+	y = y < 0.0f ? 0.0f : (y > 1.0f ? 1.0f : y);
+
+	const int xInd = (int)(x * stepX * (float)width);
+	const int yInd = (int)(y * stepY * (float)height);
+
+	return reinterpret_cast<const colour_t*>(data)[xInd + (yInd * width)];
+}
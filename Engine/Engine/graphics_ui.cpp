@@ -137,6 +137,62 @@ GUISprite::~GUISprite()
 	pTexture = nullptr;
 }
 
+/**
+ * \brief Scales every state slice of pTexture to w x h pixels, as 
+ * previously done per pixel in Graphics::drawGUIMenuSprite.
+ * 
+ * \param w Width of sprite on screen in pixels
+ * \param h Height of sprite on screen in pixels
+ * \param generation Graphics::getSizeGeneration of the screen
+ */
+void GUISprite::updateCache(const int w, const int h, const uint generation)
+{
+	cacheWidth = w > 0 ? w : 0;
+	cacheHeight = h > 0 ? h : 0;
+	cacheGeneration = generation;
+
+	// RGB textures have no state slices
+	const int numStates = pTexture->textureType == TextureType::RGBA ? pTexture->maxCylcesX : 1;
+	const size_t stateSize = (size_t)cacheWidth * cacheHeight;
+	vStateCache.assign(stateSize * numStates + 1, 0);  // +1 keeps empty sprites valid
+
+	for (int n = 0; n < numStates; n++)
+	{
+		colour_t* pixel = vStateCache.data() + stateSize * n;
+		for (int j = 0; j < cacheHeight; j++)
+		{
+			const float y_ = normalise((float)j, 0.0f, (float)cacheHeight);
+			for (int i = 0; i < cacheWidth; i++)
+			{
+				const float x_ = normalise((float)i, 0.0f, (float)cacheWidth);
+				*pixel++ = pTexture->lookUp(x_, y_, n + 1);
+			}
+		}
+	}
+
+	if (pTexture->textureType == TextureType::RGBA)
+	{
+		premultiplyAlpha(vStateCache.data(), stateSize * numStates);
+	}
+}
+
+/**
+ * \brief Returns the cached pixels of the current state.
+ * 
+ * \see updateCache
+ */
+const colour_t* GUISprite::getCachedState() const
+{
+	if (pTexture->textureType != TextureType::RGBA)
+	{
+		return vStateCache.data();
+	}
+
+	int n = (int)state;
+	clamp(&n, 1, pTexture->maxCylcesX);
+	return vStateCache.data() + (size_t)cacheWidth * cacheHeight * (n - 1);
+}
+
 const int GUISprite::getState()
 {
 	return (int)state;
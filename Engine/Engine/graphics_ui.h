@@ -13,6 +13,7 @@
 #include "types.h"
 #include "graphics.h"
 #include "graphics_texture.h"
+#include "graphics_textlayout.h"
 #include <string>
 #include <vector>
 
@@ -61,6 +62,7 @@ struct GUIText
 	colour_t cBackground;				///< Colour of background (whitespace 
 										///< behind text)
 	bool drawBackground;				///< Boolean to draw background colour
+	mutable TextLayout layout;			///< Retained layout of drawn text
 
 	GUIText(const std::string sText, const colour_t colours[3],
 		const float x1, const float y1,
@@ -126,6 +128,14 @@ struct GUISprite
 											///< to index of sprite to draw
 	Texture* pTexture = nullptr;			///< Pointer to the texture of sprite
 
+private:
+	std::vector<colour_t> vStateCache;		///< Every state slice scaled to screen 
+											///< pixels, premultiplied for RGBA
+	int cacheWidth = 0;						///< Width of each cached state
+	int cacheHeight = 0;					///< Height of each cached state
+	uint cacheGeneration = 0;				///< Graphics::getSizeGeneration when cached
+
+public:
 	GUISprite(
 		const char* filename, TextureType textureType, const int sectionWidth, const int sectionHeight,
 		const float x1, const float y1, const float x2, const float y2);
@@ -133,4 +143,15 @@ struct GUISprite
 	const int getState();
 	const bool isClickable(const Vec2f& vf);
 	Texture* Tex();
+
+	void updateCache(const int w, const int h, const uint generation);
+	const colour_t* getCachedState() const;
+
+	/**
+	 * \brief Returns true if the cache was built for this size.
+	 */
+	const bool isCacheValid(const int w, const int h, const uint generation) const
+	{
+		return !vStateCache.empty() && cacheWidth == w && cacheHeight == h && cacheGeneration == generation;
+	}
 };
\ No newline at end of file
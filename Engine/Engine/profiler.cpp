@@ -0,0 +1,163 @@
+#include "profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+std::atomic<bool> Profiler::enabled{ false };
+const std::chrono::steady_clock::time_point Profiler::epoch = std::chrono::steady_clock::now();
+
+/**
+ * \brief Returns the global profiler.
+ */
+Profiler& Profiler::get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+/**
+ * \brief Returns the ring buffer of the calling thread, creating and
+ * registering it on first use.
+ *
+ * \note Buffers are never freed so that exportChromeTrace can still read
+ * events from threads which have already exited.
+ */
+ProfileThreadBuffer& Profiler::threadBuffer()
+{
+	thread_local ProfileThreadBuffer* pThreadBuffer = nullptr;
+	if (pThreadBuffer == nullptr)
+	{
+		pThreadBuffer = new ProfileThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(mtxBuffers);
+		pThreadBuffer->threadId = (uint32_t)vBuffers.size();
+		vBuffers.push_back(pThreadBuffer);
+	}
+	return *pThreadBuffer;
+}
+
+/**
+ * \brief Marks the start of a new frame.
+ */
+void Profiler::beginFrame()
+{
+	frameStart = now();
+}
+
+/**
+ * \brief Marks the end of the current frame and builds the summary of it.
+ *
+ * Every event of the finished frame, from every thread, is grouped by name
+ * and depth in the order the scopes were opened so that the summary reads
+ * as a hierarchy.
+ */
+void Profiler::endFrame()
+{
+	const uint32_t finished = frame.load(std::memory_order_relaxed);
+	fFrameMs = (float)(now() - frameStart) / 1e6f;
+
+	if (enabled.load(std::memory_order_relaxed))
+	{
+		std::vector<ProfileEvent> events;
+		{
+			std::lock_guard<std::mutex> lock(mtxBuffers);
+			for (auto b : vBuffers)
+			{
+				const uint32_t head = b->head.load(std::memory_order_acquire);
+				const uint32_t count = std::min<uint32_t>(head, PROFILER_RING_SIZE);
+				for (uint32_t i = 1; i <= count; i++)
+				{
+					const ProfileEvent& e = b->events[(head - i) % PROFILER_RING_SIZE];
+					if (e.frame < finished)
+					{
+						break;
+					}
+					if (e.frame == finished)
+					{
+						events.push_back(e);
+					}
+				}
+			}
+		}
+
+		std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+			{
+				return a.start < b.start;
+			});
+
+		summary.clear();
+		for (auto& e : events)
+		{
+			auto it = std::find_if(summary.begin(), summary.end(), [&e](const ProfileSummary& s)
+				{
+					return s.name == e.name && s.depth == e.depth;
+				});
+			const float fMs = (float)(e.end - e.start) / 1e6f;
+			if (it == summary.end())
+			{
+				summary.push_back({ e.name, e.depth, fMs, 1 });
+			}
+			else
+			{
+				it->fMs += fMs;
+				it->calls++;
+			}
+		}
+	}
+
+	frame.store(finished + 1, std::memory_order_relaxed);
+}
+
+/**
+ * \brief Writes every event still held in the ring buffers to a file in the
+ * Chrome trace_event format (load with chrome://tracing or Perfetto).
+ *
+ * \param filename Relative filename ending in .json
+ * \return Returns true if successful, otherwise false
+ *
+ * \note No other thread may be recording events, as a full ring's oldest
+ * event is the next one overwritten. Game waits for its FramePipeline first.
+ */
+const bool Profiler::exportChromeTrace(const std::string& filename)
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cerr
+			<< "Error exporting trace: " << filename
+			<< " -> Could not open file\n";
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(mtxBuffers);
+	for (auto b : vBuffers)
+	{
+		const uint32_t head = b->head.load(std::memory_order_acquire);
+		const uint32_t count = std::min<uint32_t>(head, PROFILER_RING_SIZE);
+		for (uint32_t i = head - count; i != head; i++)
+		{
+			const ProfileEvent& e = b->events[i % PROFILER_RING_SIZE];
+			if (!first)
+			{
+				file << ",\n";
+			}
+			first = false;
+
+			file << "{\"name\":\"" << e.name << "\",\"cat\":\"frame\",\"ph\":\"X\""
+				<< ",\"ts\":" << (double)e.start / 1000.0
+				<< ",\"dur\":" << (double)(e.end - e.start) / 1000.0
+				<< ",\"pid\":0,\"tid\":" << b->threadId
+				<< ",\"args\":{\"frame\":" << e.frame << "}}";
+		}
+	}
+
+	file << "\n]}\n";
+
+	std::cerr << "Exported trace to " << filename << "\n";
+	return true;
+}
@@ -0,0 +1,177 @@
+/*****************************************************************//**
+ * \file   profiler.h
+ * \brief  Contains Profiler class and PROFILE_SCOPE macro for measuring
+ * where frame time is spent
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "types.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILER_RING_SIZE	(1 << 14)	///< Number of events stored per thread
+#define PROFILER_MAX_DEPTH	(16)		///< Maximum nesting of scopes per thread
+
+/**
+ * \brief Opens a named profiling scope that closes at the end of the
+ * enclosing block.
+ *
+ * Define DISABLE_PROFILER to compile all scopes out. Otherwise a scope only
+ * costs a single branch while the profiler is disabled at runtime.
+ *
+ * \note name must be a string literal (only the pointer is stored).
+ */
+#ifdef DISABLE_PROFILER
+	#define PROFILE_SCOPE(name)
+#else
+	#define PROFILE_CONCAT_(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+	#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#endif
+
+/**
+ * \brief Single timed scope as recorded in a thread's ring buffer.
+ */
+struct ProfileEvent
+{
+	const char* name = nullptr;	///< Name of scope (string literal)
+	int64_t start = 0;			///< Start time in nanoseconds since profiler epoch
+	int64_t end = 0;			///< End time in nanoseconds since profiler epoch
+	uint32_t frame = 0;			///< Frame the scope was opened in
+	uint16 depth = 0;			///< Nesting depth of scope (0 = outermost)
+};
+
+/**
+ * \brief Ring buffer of events owned by a single thread.
+ *
+ * Only the owning thread writes to the buffer. Old events are overwritten
+ * once PROFILER_RING_SIZE is exceeded.
+ */
+struct ProfileThreadBuffer
+{
+	uint32_t threadId = 0;							///< Small sequential id used in traces
+	std::vector<ProfileEvent> events;				///< Ring of completed events
+	std::atomic<uint32_t> head{ 0 };				///< Total number of events written
+	int depth = 0;									///< Current nesting depth
+	int64_t openStart[PROFILER_MAX_DEPTH] = {};	///< Start times of open scopes
+
+	ProfileThreadBuffer() : events(PROFILER_RING_SIZE) {}
+};
+
+/**
+ * \brief Summary of a named scope for the last completed frame.
+ */
+struct ProfileSummary
+{
+	const char* name;	///< Name of scope
+	int depth;			///< Nesting depth of scope
+	float fMs;			///< Total milliseconds spent in scope during the frame
+	int calls;			///< Number of times scope was entered during the frame
+};
+
+/**
+ * \brief Collects timed scopes from every thread and summarises them per
+ * frame.
+ *
+ * Scopes are pushed into per-thread ring buffers with no locking. Frames are
+ * marked with beginFrame()/endFrame() from the main thread, after which
+ * getSummary() describes the hierarchy of the frame just finished.
+ */
+class Profiler
+{
+public:
+	static std::atomic<bool> enabled;	///< Runtime switch checked by every scope
+
+	static Profiler& get();
+	static inline int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	void beginFrame();
+	void endFrame();
+	uint32_t getFrame() const { return frame.load(std::memory_order_relaxed); }
+	const std::vector<ProfileSummary>& getSummary() const { return summary; }
+	float getFrameMs() const { return fFrameMs; }
+
+	const bool exportChromeTrace(const std::string& filename);
+
+	ProfileThreadBuffer& threadBuffer();
+
+private:
+	Profiler() = default;
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	static const std::chrono::steady_clock::time_point epoch;
+
+	std::mutex mtxBuffers;								///< Guards vBuffers
+	std::vector<ProfileThreadBuffer*> vBuffers;		///< Every thread that has recorded events
+	std::atomic<uint32_t> frame{ 0 };					///< Current frame number
+	int64_t frameStart = 0;								///< Start time of current frame
+	float fFrameMs = 0.0f;								///< Duration of last completed frame
+	std::vector<ProfileSummary> summary;				///< Summary of last completed frame
+};
+
+/**
+ * \brief RAII helper that records a ProfileEvent between construction and
+ * destruction.
+ *
+ * \see PROFILE_SCOPE
+ */
+class ProfileScope
+{
+private:
+	ProfileThreadBuffer* pBuffer = nullptr;
+	const char* name;
+
+public:
+	explicit ProfileScope(const char* name) : name(name)
+	{
+		if (!Profiler::enabled.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		pBuffer = &Profiler::get().threadBuffer();
+		if (pBuffer->depth < PROFILER_MAX_DEPTH)
+		{
+			pBuffer->openStart[pBuffer->depth] = Profiler::now();
+		}
+		pBuffer->depth++;
+	}
+
+	~ProfileScope()
+	{
+		if (pBuffer == nullptr)
+		{
+			return;
+		}
+
+		pBuffer->depth--;
+		if (pBuffer->depth >= PROFILER_MAX_DEPTH)
+		{
+			return;  // too deep to record
+		}
+
+		const uint32_t head = pBuffer->head.load(std::memory_order_relaxed);
+		ProfileEvent& e = pBuffer->events[head % PROFILER_RING_SIZE];
+		e.name = name;
+		e.start = pBuffer->openStart[pBuffer->depth];
+		e.end = Profiler::now();
+		e.frame = Profiler::get().getFrame();
+		e.depth = (uint16)pBuffer->depth;
+		pBuffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,136 @@
+#include "utils_file.h"
+#include <iostream>
+
+#ifdef _WIN32
+	#include "hwindows.h"
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+/**
+ * \brief Maps filename into memory, closing any file already open.
+ *
+ * An empty file opens with data() nullptr and size() 0.
+ *
+ * \return Returns true if successful, otherwise false
+ */
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not open file\n";
+		return false;
+	}
+	hFile = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not get file size\n";
+		close();
+		return false;
+	}
+	if (fileSize.QuadPart == 0)
+	{
+		return true;
+	}
+
+	hMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (hMapping == nullptr)
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not create file mapping\n";
+		close();
+		return false;
+	}
+
+	pData = (const char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (pData == nullptr)
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not map view of file\n";
+		close();
+		return false;
+	}
+	nSize = (size_t)fileSize.QuadPart;
+#else
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not open file\n";
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not get file size\n";
+		close();
+		return false;
+	}
+	if (st.st_size == 0)
+	{
+		return true;
+	}
+
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		std::cerr << "Error mapping: " << filename << " -> Could not map file\n";
+		close();
+		return false;
+	}
+	madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+	pData = (const char*)view;
+	nSize = (size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+/**
+ * \brief Unmaps and closes the file, if one is open.
+ */
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (pData != nullptr)
+	{
+		UnmapViewOfFile(pData);
+	}
+	if (hMapping != nullptr)
+	{
+		CloseHandle(hMapping);
+		hMapping = nullptr;
+	}
+	if (hFile != nullptr)
+	{
+		CloseHandle(hFile);
+		hFile = nullptr;
+	}
+#else
+	if (pData != nullptr)
+	{
+		munmap((void*)pData, nSize);
+	}
+	if (fd >= 0)
+	{
+		::close(fd);
+		fd = -1;
+	}
+#endif
+
+	pData = nullptr;
+	nSize = 0;
+}
@@ -0,0 +1,46 @@
+/*****************************************************************//**
+ * \file   utils_file.h
+ * \brief  Contains MappedFile class to read whole files through the
+ * operating system's memory mapping
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * \brief Read-only view of a file mapped into memory.
+ *
+ * Pages are read by the operating system as they are touched, so large
+ * files are not copied into a buffer before they can be parsed and several
+ * threads can read different parts at once.
+ *
+ * \note The mapping is not null terminated, use size().
+ */
+class MappedFile
+{
+private:
+#ifdef _WIN32
+	void* hFile = nullptr;		///< HANDLE of the file
+	void* hMapping = nullptr;	///< HANDLE of the mapping
+#else
+	int fd = -1;
+#endif
+	const char* pData = nullptr;
+	size_t nSize = 0;
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool open(const std::string& filename);
+	void close();
+
+	const char* data() const { return pData; }
+	size_t size() const { return nSize; }
+};
@@ -47,6 +47,8 @@ void Win32Graphics::Render()
 
 void Win32Graphics::ChangeSize(int newWidth, int newHeight)
 {
+	std::lock_guard<std::mutex> lock(mtxFrame);  // buffers are freed below
+
 	int bufferSize;
 	//width = rect->right - rect->left;
 	//height = rect->bottom - rect->top;
@@ -75,8 +77,5 @@ void Win32Graphics::ChangeSize(int newWidth, int newHeight)
 	}
 	pDepthBuffer = VirtualAlloc(0, bufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
 
-	for (auto s : sprites)
-	{
-		s->updateSize();
-	}
+	onSizeChanged();
 }
\ No newline at end of file
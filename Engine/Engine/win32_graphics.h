@@ -1,6 +1,7 @@
 #pragma once
 #include "hwindows.h"
 #include "graphics.h"
+#include <mutex>
 #include <vector>
 
 class Win32Graphics : public Graphics
@@ -12,9 +13,12 @@ private:
 	std::vector<void(*)(const int, const int)> spritesToUpdate;	///< Vector of function pointers to 
 																///< functions that need updated 
 																///< when size changes.
+	std::mutex mtxFrame;	///< Held while a frame is drawn on another thread,
+							///< ChangeSize waits for it
 
 public:
 	Win32Graphics(HWND hwnd, HDC hdc);
 	void Render();
 	void ChangeSize(int width, int height);
+	std::mutex& frameMutex() { return mtxFrame; }
 };
\ No newline at end of file
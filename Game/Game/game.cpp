@@ -1,6 +1,7 @@
 #include "Engine/defines.h"
 #include "Engine/graphics_objects.h"
 #include "Engine/graphics_ui.h"
+#include "Engine/profiler.h"
 #include "Engine/utils_vector.h"
 #include "game.h"
 #include <list>
@@ -26,13 +27,19 @@
 /* Game Methods */
 
 Game::Game(const char* name, int width, int height)
-	: win(name, width, height)
+	: win(name, width, height), uiCompositor(win.Gfx())
 {
 	userTextBuffer = new std::string;
+
+	for (auto& snapshot : snapshots)
+	{
+		snapshot = std::make_unique<RenderSnapshot>(win.Gfx());
+	}
 }
 
 Game::~Game()
 {
+	framePipeline.stop();
 }
 
 /**
@@ -78,6 +85,8 @@ const int Game::run()
 		gsPush(&Game::gsMainMenu, FLAG_INIT);
 	}
 
+	framePipeline.start([this](const int slot) { glRenderSnapshot(*snapshots[slot]); });
+
 	while (Window::processMessages())
 	{
 		if (sGameStates.empty())
@@ -85,15 +94,33 @@ const int Game::run()
 			break;
 		}
 
-		// Get current game state
-		std::pair<void (Game::*)(int), int> current = sGameStates.top();
-		void (Game:: * currentState)(int) = current.first;
-		int currentFlag = current.second;
+		Profiler::get().beginFrame();
+		{
+			PROFILE_SCOPE("Frame");
+
+			// Get current game state
+			std::pair<void (Game::*)(int), int> current = sGameStates.top();
+			void (Game:: * currentState)(int) = current.first;
+			int currentFlag = current.second;
 
-		(this->*currentState)(currentFlag);  // execute method
+			// Only gsGame draws through framePipeline, other states draw on 
+			// this thread once it has finished
+			if (currentState != &Game::gsGame || currentFlag != FLAG_RUN)
+			{
+				framePipeline.wait();
+			}
 
-		/* ---------- Draw to window ---------- */
-		win.Gfx().Render();  // last
+			frameSubmitted = false;
+			(this->*currentState)(currentFlag);  // execute method
+
+			/* ---------- Draw to window ---------- */
+			if (!frameSubmitted)
+			{
+				PROFILE_SCOPE("Present");
+				win.Gfx().Render();  // last
+			}
+		}
+		Profiler::get().endFrame();
 
 		/* --------- Update Frame time -------- */
 		win.updateFrameTime();
@@ -319,7 +346,8 @@ void Game::gsCloseApplication(int flag)
  * \brief Handles the main game state.
  * 
  * When flag == FLAG_INIT: Will initialise game through glInit().
- * When flag == FLAG_RUN: Will call glInput(), glSimulate() and glRender().
+ * When flag == FLAG_RUN: Will call glInput(), glSimulate() and glRender(),
+ * or glSubmitFrame() when frames are pipelined.
  * When flag == FLAG_DESTROY: Will cleanup game through glDestroy().
  */
 void Game::gsGame(const int flag)
@@ -334,13 +362,28 @@ void Game::gsGame(const int flag)
 	} break;
 	case FLAG_RUN:
 	{
-		glInput();
-		glSimulate();
-		glRender();
+		{
+			PROFILE_SCOPE("Input");
+			glInput();
+		}
+		{
+			PROFILE_SCOPE("Simulate");
+			glSimulate();
+		}
+		if (pipelineFrames)
+		{
+			glSubmitFrame();
+		}
+		else
+		{
+			framePipeline.wait();
+			glRender();
+		}
 	} break;
 	case FLAG_DESTROY:
 	{
 		std::cerr << "gsGame() -> FLAG_DESTROY\n";
+		framePipeline.wait();  // may be popped during a pipelined frame
 		glDestroy();
 	} break;
 	default:
@@ -505,6 +548,9 @@ void Game::glInit()
 	pTextureGrass = new Texture(TextureType::RGB, "cubemap_grass.bmp", 16, 16);
 	pTextureStone = new Texture(TextureType::RGB, "cubemap_stone.bmp", 16, 16);
 
+	// Every block shares one cube
+	pMeshCube = new Mesh();
+	pMeshCube->LoadTestCube("Cube");
 
 	// Populate world with objects
 	worldCoords = new Object*[game_settings.world_num_objects_x * game_settings.world_num_objects_y * game_settings.world_num_objects_z];
@@ -528,7 +574,8 @@ void Game::glInit()
 					name = "Dirt";
 					o->pTexture = pTextureDirt;
 				}
-				o->LoadTestCube(name);
+				o->name = name;
+				o->pMesh = pMeshCube;
 				o->setPos((float)x, (float)y, (float)z);
 				//worldCoords[x + game_settings.world_num_objects_x * (y + game_settings.world_num_objects_z * z)] = o;
 				setWorldObject(o, x, y, z);
@@ -573,6 +620,13 @@ void Game::glDestroy()
 {
 	glInitialised = false;
 
+	// Results of drawn snapshots point at objects deleted below
+	for (auto& snapshot : snapshots)
+	{
+		snapshot->isLookingAtObject = false;
+		snapshot->vSources.clear();
+	}
+
 	for (int i = 0; i < game_settings.world_num_objects_x * game_settings.world_num_objects_y * game_settings.world_num_objects_z; i++)
 	{
 		delete worldCoords[i];
@@ -580,6 +634,8 @@ void Game::glDestroy()
 	}
 	delete[] worldCoords;
 	worldCoords = nullptr;
+	delete pMeshCube;
+	pMeshCube = nullptr;
 
 	delete pTextureDirt;
 	pTextureDirt = nullptr;
@@ -688,6 +744,32 @@ void Game::glInput()
 		{
 			std::cerr << player.inventory << "\n";
 		} break;
+		case VK_F3:
+		{
+			// Toggle profiler and its overlay
+			if (event.isReleased())
+			{
+				showProfiler = !showProfiler;
+				Profiler::enabled = showProfiler;
+			}
+		} break;
+		case VK_F4:
+		{
+			// Dump recorded frames for chrome://tracing
+			if (event.isReleased())
+			{
+				framePipeline.wait();  // render thread must not record while the rings are read
+				Profiler::get().exportChromeTrace("profile.json");
+			}
+		} break;
+		case VK_F5:
+		{
+			// Toggle drawing frames on the render thread
+			if (event.isReleased())
+			{
+				pipelineFrames = !pipelineFrames;
+			}
+		} break;
 		}
 	}
 
@@ -814,7 +896,7 @@ void Game::glSimulate()
 		{
 			std::cerr << "PlayerAction -> Place\n";
 			//Object* o = player.inventory.pop(player.inventory.currentSlot);
-			Object* oHit = player.objectVisable.objectHit;
+			Object* oHit = static_cast<Object*>(player.objectVisable.objectHit);
 			Vec3f vHit = oHit->vPos;
 			if (oHit != nullptr)
 			{
@@ -851,7 +933,7 @@ void Game::glSimulate()
 		if (player.isLookingAtObject)
 		{
 			std::cerr << "PlayerAction -> Remove\n";
-			Object* o = player.objectVisable.objectHit;
+			Object* o = static_cast<Object*>(player.objectVisable.objectHit);
 			Vec3f v = o->vPos;
 			player.inventory.push(o);
 			setWorldObject(nullptr, (int)v.x, (int)v.y, (int)v.z);
@@ -953,13 +1035,13 @@ void Game::glSimulate()
 
 /**
  * \brief Renders objects for Game loop.
+ * 
+ * \param guiMenu Menu drawn over the HUD (optional)
  * \see Called by gsGame().
  */
-void Game::glRender()
+void Game::glRender(GUIMenu* guiMenu)
 {
-	// Clear screen and depth buffer
-	win.Gfx().clearScreen(0xcdcdcd);
-	win.Gfx().clearDepthBuffer();
+	PROFILE_SCOPE("Render");
 
 	// Draw objects in scene
 	//std::vector<Object*> objects;
@@ -968,6 +1050,46 @@ void Game::glRender()
 
 	// Calculate visable objects
 	std::vector<Object*> objectsToRender;
+	glCull(objectsToRender);
+	vInstances.assign(objectsToRender.begin(), objectsToRender.end());
+	glRecordScene(sceneCommands, vInstances);
+
+	// Raster textured triangles and get current looking at object
+	uiCompositor.begin();
+	player.isLookingAtObject = sceneCommands.execute(win.Gfx(), player.objectVisable);
+
+	glDrawHUD(uiCompositor, guiMenu);
+
+	{
+		PROFILE_SCOPE("Composite UI");
+		uiCompositor.composite(CompositeMode::Overlay);
+	}
+
+	win.Gfx().drawFPS(1.0f / win.lastDT, 0x000000);
+	win.Gfx().drawPos(player.getVCamera(), player.getVelocity(), player.getAcceleration(), player.getYaw(), player.getPitch(), 0x000000);
+
+	if (showProfiler)
+	{
+		win.Gfx().drawProfiler(Profiler::get(), 0x000000);
+	}
+
+	//win.Gfx().DrawPointP(win.Gfx().getWidth() / 2, win.Gfx().getHeight() / 2, 0xff0000);
+}
+
+/**
+ * \brief Finds the objects with a face not covered by another object and 
+ * marks those faces to be drawn.
+ * 
+ * Dirt with nothing on top of it becomes grass, grass with something on top
+ * of it becomes dirt.
+ * 
+ * \param objectsToRender Cleared, then filled with the visible objects
+ */
+void Game::glCull(std::vector<Object*>& objectsToRender)
+{
+	PROFILE_SCOPE("Cull");
+
+	objectsToRender.clear();
 	for (int z = 0; z < game_settings.world_num_objects_x; z++)
 	{
 		for (int y = 0; y < game_settings.world_num_objects_y; y++)
@@ -977,7 +1099,7 @@ void Game::glRender()
 				Object* o = getWorldObject(x, y, z);
 				if (o == nullptr) continue;
 				o->resetFacesDrawable();
-				
+			
 				Object* oRight		= getWorldObject(x - 1, y	 , z);
 				Object* oLeft		= getWorldObject(x + 1, y	 , z);
 				Object* oBottom		= getWorldObject(x	 , y - 1 , z);
@@ -985,12 +1107,12 @@ void Game::glRender()
 				Object* oFront		= getWorldObject(x	 , y	 , z - 1);
 				Object* oBehind		= getWorldObject(x	 , y	 , z + 1);
 
-				if (oFront == nullptr)	o->faces[0].draw = true;
-				if (oBehind == nullptr) o->faces[1].draw = true;
-				if (oLeft == nullptr)	o->faces[2].draw = true;
-				if (oRight == nullptr)	o->faces[3].draw = true;
-				if (oTop == nullptr)	o->faces[4].draw = true;
-				if (oBottom == nullptr) o->faces[5].draw = true;
+				if (oFront == nullptr)	o->setFaceDrawable(ObjectFace::Front);
+				if (oBehind == nullptr) o->setFaceDrawable(ObjectFace::Back);
+				if (oLeft == nullptr)	o->setFaceDrawable(ObjectFace::Left);
+				if (oRight == nullptr)	o->setFaceDrawable(ObjectFace::Right);
+				if (oTop == nullptr)	o->setFaceDrawable(ObjectFace::Top);
+				if (oBottom == nullptr) o->setFaceDrawable(ObjectFace::Bottom);
 
 				if (oTop == nullptr && o->pTexture == pTextureDirt)
 				{
@@ -1007,37 +1129,169 @@ void Game::glRender()
 			}
 		}
 	}
+}
 
-	// Raster textured triangles and get current looking at object
-	player.isLookingAtObject = false;
-	colour_t colour = 0xff0000;
-	if (win.Gfx().rasterTexturedTriangles(projectionMatrix, player.getMCamera(), player.getVCamera(), 
-		player.getVLookDir(), player.objectVisable, 5.0f, objectsToRender, nullptr))
+/**
+ * \brief Records clearing the screen and drawing objects from the player's
+ * camera into commands, sorted.
+ * 
+ * \param commands Reset, then filled with the scene
+ */
+void Game::glRecordScene(RenderCommandBuffer& commands, const std::vector<MeshInstance*>& objects)
+{
+	commands.reset();
+	commands.setLayer(RenderLayer::Scene);
+	commands.clear(0xcdcdcd);
+	commands.clearDepth();
+
+	commands.setView(projectionMatrix, player.getMCamera(), player.getVCamera(), player.getVLookDir(), 5.0f);
+	for (auto o : objects)
+	{
+		commands.drawMesh(o);
+	}
+
+	commands.sort();
+}
+
+/**
+ * \brief Records the HUD (looking at, chat, sprites, inventory) and 
+ * guiMenu into ui.
+ * 
+ * \note ui.begin() must have been called this frame.
+ */
+void Game::glDrawHUD(UICompositor& ui, GUIMenu* guiMenu)
+{
+	if (player.isLookingAtObject)
 	{
 		// Object hit do something with info
-		player.isLookingAtObject = true;
-		std::stringstream strstream_;
-		strstream_ << "Looking at: " << player.objectVisable.objectHit->vPos;
-		win.Gfx().drawText(strstream_.str(), { 100, 100 }, 0x0fffff);
+		const Vec3f& vPos = static_cast<const Object*>(player.objectVisable.objectHit)->vPos;
+		if (layoutLookingAt.updateKey(vPos))
+		{
+			std::stringstream strstream_;
+			strstream_ << "Looking at: " << vPos;
+			layoutLookingAt.setText(strstream_.str());
+		}
+		ui.drawTextLayout(layoutLookingAt, { 100, 100 }, 0x0fffff);
 	}
 
-	win.Gfx().drawGUIForm(guiChat);  // todo
+	ui.drawGUIForm(guiChat);  // todo
 
-	win.Gfx().drawSprites();
+	ui.drawSprites();
 
 	/* Draw player inventory */
 
+	const int inventorySlot[2] = { (int)player.inventory.currentSlot, (int)player.inventory.maxSlots };
+	if (layoutInventorySlot.updateKey(inventorySlot))
+	{
+		layoutInventorySlot.format("Inventory slot: %d/%d", inventorySlot[0], inventorySlot[1]);
+	}
+	ui.drawTextLayout(layoutInventorySlot, {0, 20}, 0x000000);
+
+	// Slot contents can change without the slot changing, so compare text
 	std::stringstream strstream;
 	strstream << player.inventory;
-	win.Gfx().drawText("Inventory slot: " + std::to_string(player.inventory.currentSlot) + "/" + std::to_string(player.inventory.maxSlots), {0, 20}, 0x000000);
-	win.Gfx().drawText(strstream.str(), {0, 0}, 0x000000);
+	layoutInventory.setText(strstream.str());
+	ui.drawTextLayout(layoutInventory, {0, 0}, 0x000000);
 
-	win.Gfx().drawFPS(1.0f / win.lastDT, 0x000000);
-	win.Gfx().drawPos(player.getVCamera(), player.getVelocity(), player.getAcceleration(), player.getYaw(), player.getPitch(), 0x000000);
+	if (guiMenu != nullptr)
+	{
+		ui.drawGUIMenu(guiMenu);
+	}
+}
 
-	//win.Gfx().DrawPointP(win.Gfx().getWidth() / 2, win.Gfx().getHeight() / 2, 0xff0000);
+/**
+ * \brief Records this frame into a RenderSnapshot and hands it to 
+ * framePipeline, which draws it while the next frame is simulated.
+ * 
+ * The looking at object comes from the last snapshot drawn in the same 
+ * slot, so it is a frame or two behind the camera. It is dropped if the 
+ * object has since been removed or moved.
+ * 
+ * \see Called by gsGame() instead of glRender(). Drawn by glRenderSnapshot().
+ */
+void Game::glSubmitFrame()
+{
+	PROFILE_SCOPE("Record");
+
+	const int slot = framePipeline.acquire();
+	RenderSnapshot& snapshot = *snapshots[slot];
+
+	// Results of the frame last drawn in this slot
+	player.isLookingAtObject = false;
+	if (snapshot.isLookingAtObject)
+	{
+		Object* o = snapshot.getSource(snapshot.objectHit.objectHit);
+		if (o != nullptr && getWorldObject((int)o->vPos.x, (int)o->vPos.y, (int)o->vPos.z) == o)
+		{
+			player.objectVisable = snapshot.objectHit;
+			player.objectVisable.objectHit = o;
+			player.objectVisable.triangleHit = -1;  // triangle of the copy
+			player.isLookingAtObject = true;
+		}
+	}
+
+	glCull(vVisible);
+	snapshot.setObjects(vVisible);
+	glRecordScene(snapshot.commands, snapshot.vDraw);
+
+	snapshot.ui.begin();
+	glDrawHUD(snapshot.ui, nullptr);
+	snapshot.sizeGeneration = win.Gfx().getSizeGeneration();
+
+	snapshot.fFPS = 1.0f / win.lastDT;
+	snapshot.vCamera = player.getVCamera();
+	snapshot.vVelocity = player.getVelocity();
+	snapshot.accelerationFlags = player.getAcceleration();
+	snapshot.fYaw = player.getYaw();
+	snapshot.fPitch = player.getPitch();
+
+	snapshot.showProfiler = showProfiler;
+	if (showProfiler)
+	{
+		snapshot.fProfileMs = Profiler::get().getFrameMs();
+		snapshot.vProfile = Profiler::get().getSummary();
+	}
+
+	framePipeline.submit(slot);
+	frameSubmitted = true;
 }
 
+/**
+ * \brief Draws and presents a snapshot recorded by glSubmitFrame().
+ * 
+ * \note Runs on the render thread of framePipeline, so only snapshot and 
+ * the buffers of win.Gfx() may be used.
+ */
+void Game::glRenderSnapshot(RenderSnapshot& snapshot)
+{
+	PROFILE_SCOPE("Render");
+
+	Win32Graphics& gfx = win.Gfx();
+	std::lock_guard<std::mutex> lock(gfx.frameMutex());
+
+	snapshot.isLookingAtObject = snapshot.commands.execute(gfx, snapshot.objectHit);
+
+	// Sprites may have been rescaled since the HUD was recorded. The next
+	// composite redraws the whole overlay for the new size
+	if (snapshot.sizeGeneration == gfx.getSizeGeneration())
+	{
+		PROFILE_SCOPE("Composite UI");
+		snapshot.ui.composite(CompositeMode::Overlay);
+	}
+
+	gfx.drawFPS(snapshot.fFPS, 0x000000);
+	gfx.drawPos(snapshot.vCamera, snapshot.vVelocity, snapshot.accelerationFlags, snapshot.fYaw, snapshot.fPitch, 0x000000);
+
+	if (snapshot.showProfiler)
+	{
+		gfx.drawProfiler(snapshot.fProfileMs, snapshot.vProfile, 0x000000);
+	}
+
+	{
+		PROFILE_SCOPE("Present");
+		gfx.Render();
+	}
+}
 
 /* Menu Methods */
 
@@ -1165,14 +1419,23 @@ void Game::mMain()
 
 	//win.Gfx().drawColourBuffer(sprite->pData, sprite->vf1, sprite->vf2);
 
-	win.Gfx().drawSprites();
+	// Nothing else draws to the screen, so only what changed is redrawn
+	uiCompositor.begin();
+	uiCompositor.drawSprites();
 
 	for (auto b : mainMenu->buttons)
 	{
-		win.Gfx().drawGUIMenuSprite(b->sprite);
+		uiCompositor.drawGUIMenuSprite(b->sprite);
 	}
 
-	win.Gfx().drawFPS(1.0f / win.lastDT, 0x0fffff);
+	const float fFPS = 1.0f / win.lastDT;
+	if (layoutMenuFPS.updateKey(fFPS))
+	{
+		layoutMenuFPS.format("FPS: %.2f", fFPS);
+	}
+	uiCompositor.drawTextLayout(layoutMenuFPS, { 0, win.Gfx().getHeight() - 20 }, 0x0fffff);
+
+	uiCompositor.composite(CompositeMode::Exclusive);
 }
 
 /**
@@ -1254,9 +1517,7 @@ void Game::mGame()
 
 	/* ---------- Render ---------- */
 
-	glRender();
-
-	win.Gfx().drawGUIMenu(guiGameMenu);
+	glRender(guiGameMenu);
 }
 
 
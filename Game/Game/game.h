@@ -9,10 +9,15 @@
 #pragma once
 #include "Engine\hwindows.h"  // first
 #include "Engine\win32_window.h"
+#include "Engine\graphics_commands.h"
+#include "Engine\graphics_compositor.h"
 #include "Engine\utils_vector.h"
 #include "Engine\graphics_objects.h"
+#include "Engine\frame_pipeline.h"
 #include "player.h"
 #include "game_menus.h"
+#include "game_snapshot.h"
+#include <memory>
 #include <stack>
 #include <utility>
 
@@ -61,7 +66,12 @@ private:
 	void glDestroy();
 	void glInput();
 	void glSimulate();
-	void glRender();
+	void glRender(GUIMenu* guiMenu = nullptr);
+	void glCull(std::vector<Object*>& objectsToRender);
+	void glRecordScene(RenderCommandBuffer& commands, const std::vector<MeshInstance*>& objects);
+	void glDrawHUD(UICompositor& ui, GUIMenu* guiMenu);
+	void glSubmitFrame();
+	void glRenderSnapshot(RenderSnapshot& snapshot);
 
 	/* Menu Methods */
 	void mMain();
@@ -114,6 +124,7 @@ private:
 	Texture* pTextureGrass = nullptr;
 	Texture* pTextureDirt = nullptr;
 	Texture* pTextureStone = nullptr;
+	Mesh* pMeshCube = nullptr;		///< Shared by every block
 
 private:
 	/* Player */
@@ -132,6 +143,30 @@ private:
 	GUIMenu* guiGameMenu = nullptr;
 	MainMenu* mainMenu = nullptr;
 
+	// HUD text retained between frames
+	TextLayout layoutLookingAt;
+	TextLayout layoutInventorySlot;
+	TextLayout layoutInventory;
+	TextLayout layoutMenuFPS;
+
+	UICompositor uiCompositor;	///< Draws menus and HUD over the frame
+	RenderCommandBuffer sceneCommands;	///< Scene drawn by glRender
+	std::vector<MeshInstance*> vInstances;	///< Objects recorded by glRender
+
+private:
+	/* Profiling */
+	bool showProfiler = false;	///< Toggled with F3, draws Profiler summary
+
+private:
+	/* Pipelined Rendering */
+	bool pipelineFrames = false;	///< Toggled with F5, frames are drawn on
+									///< a render thread (see glSubmitFrame)
+	bool frameSubmitted = false;	///< Frame is presented by framePipeline
+	std::unique_ptr<RenderSnapshot> snapshots[FRAME_PIPELINE_SLOTS];
+	std::vector<Object*> vVisible;	///< Objects found by glCull for snapshots
+	FramePipeline framePipeline;	///< Draws snapshots (last, so its thread 
+									///< stops before anything it uses is destroyed)
+
 private:
 	/* Old GUI Collision Checks */
 	bool CheckReturnRect(GUIRect* r, std::string*& s);
@@ -0,0 +1,44 @@
+#include "game_snapshot.h"
+
+RenderSnapshot::RenderSnapshot(Graphics& gfx)
+	: ui(gfx)
+{
+	ui.copyText = true;
+}
+
+/**
+ * \brief Copies the instance state of objects into vObjects.
+ *
+ * \param objects Visible objects (see Game::glCull)
+ */
+void RenderSnapshot::setObjects(const std::vector<Object*>& objects)
+{
+	if (vObjects.size() < objects.size())
+	{
+		vObjects.resize(objects.size());
+	}
+	vSources.assign(objects.begin(), objects.end());
+	vDraw.resize(objects.size());
+
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		vObjects[i] = *objects[i];  // slices to the MeshInstance
+		vDraw[i] = &vObjects[i];
+	}
+}
+
+/**
+ * \brief Returns the object a copy in vObjects was made from.
+ *
+ * \return Returns nullptr if copy is not in use
+ */
+Object* RenderSnapshot::getSource(const MeshInstance* copy) const
+{
+	if (copy == nullptr || vObjects.empty())
+	{
+		return nullptr;
+	}
+
+	const size_t i = (size_t)(copy - vObjects.data());
+	return i < vSources.size() ? vSources[i] : nullptr;
+}
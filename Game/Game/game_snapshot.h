@@ -0,0 +1,58 @@
+/*****************************************************************//**
+ * \file   game_snapshot.h
+ * \brief  Contains RenderSnapshot, everything needed to draw one frame of
+ * the game while the game thread simulates the next one.
+ *
+ * \author Chris
+ * \date   October 2026
+ *********************************************************************/
+
+#pragma once
+#include "Engine\graphics_commands.h"
+#include "Engine\graphics_compositor.h"
+#include "Engine\graphics_objects.h"
+#include "Engine\profiler.h"
+#include "Engine\utils_vector.h"
+#include <vector>
+
+/**
+ * \brief Frame recorded by the game thread and drawn by the render thread.
+ *
+ * Nothing in a snapshot points at state the game thread changes: visible
+ * objects are copied as MeshInstances, which share the game's meshes but
+ * keep their own transform, texture and drawn faces, and the HUD is recorded
+ * into a UICompositor of its own which copies its text. Vectors are reused
+ * between frames so recording does not allocate once they have grown.
+ *
+ * \see Game::glSubmitFrame, FramePipeline
+ */
+struct RenderSnapshot
+{
+	/* Scene */
+	RenderCommandBuffer commands;	///< Clears and meshes of vDraw
+	std::vector<MeshInstance> vObjects;	///< Copies of visible objects (only
+										///< the first vDraw.size() are in use)
+	std::vector<Object*> vSources;		///< Object each copy was made from
+	std::vector<MeshInstance*> vDraw;	///< Copies in use
+
+	/* HUD */
+	UICompositor ui;				///< Menus and text drawn over the frame
+	uint sizeGeneration = 0;		///< Graphics size ui was recorded for
+	float fFPS = 0.0f;
+	Vec4f vCamera;
+	Vec4f vVelocity;
+	uint accelerationFlags = 0;
+	float fYaw = 0.0f;
+	float fPitch = 0.0f;
+	bool showProfiler = false;
+	float fProfileMs = 0.0f;					///< Profiler::getFrameMs
+	std::vector<ProfileSummary> vProfile;		///< Profiler::getSummary
+
+	/* Results (written when drawn) */
+	bool isLookingAtObject = false;
+	ObjectHit objectHit;			///< Hit of a copy (see getSource)
+
+	explicit RenderSnapshot(Graphics& gfx);
+	void setObjects(const std::vector<Object*>& objects);
+	Object* getSource(const MeshInstance* copy) const;
+};